@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "core/model.hpp"
+
+// Tiny timing harness for the headless core, see bench/main.cpp
+
+namespace dm::bench {
+
+	// Runs fn until a minimum amount of time has passed and prints the mean
+	// time per run. If bytes is non-zero, also prints the throughput.
+	void measure(std::string const& name, size_t bytes,
+		std::function<void()> const& fn);
+
+	// Keeps the optimizer from discarding a computed value
+	inline void const* volatile sink = nullptr;
+	template <typename T>
+	void doNotOptimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r"(&value) : "memory");
+#else
+		sink = &value;
+#endif
+	}
+
+	// Deterministic synthetic data, roughly shaped like a real level
+	std::vector<Vec2> makePositions(size_t count, uint32_t seed = 1);
+	std::vector<uint8_t> makeListBody(size_t count, bool hasPercentage,
+		uint32_t seed = 1);
+	std::vector<uint8_t> makeAnalysisBody(size_t count, uint32_t seed = 1);
+	// Same deaths as version 2, idents sent once per player
+	std::vector<uint8_t> makeAnalysisDictionaryBody(size_t count,
+		uint32_t seed = 1);
+
+	// Suites
+	void benchParsing();
+	void benchLocal();
+	void benchClustering();
+	void benchSpam();
+	void benchSearch();
+	void benchStore();
+	void benchHeatmap();
+
+}
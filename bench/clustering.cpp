@@ -0,0 +1,27 @@
+#include <algorithm>
+#include "bench.hpp"
+#include "core/cluster.hpp"
+
+using namespace dm;
+
+void bench::benchClustering() {
+	for (size_t count : { 1'000, 5'000 }) {
+		auto positions = makePositions(count);
+		std::sort(positions.begin(), positions.end(),
+			[](Vec2 const& a, Vec2 const& b) { return a.x < b.x; });
+
+		measure("identifyClusters/" + std::to_string(count), 0, [&] {
+			std::vector<DeathLocationStack> stacks;
+			identifyClusters(positions, 40, &stacks);
+			doNotOptimize(stacks);
+		});
+	}
+
+	for (size_t count : { 100, 10'000 }) {
+		auto const positions = makePositions(count);
+		measure("makeSmallestEnclosingCircle/" + std::to_string(count), 0, [&] {
+			auto circle = makeSmallestEnclosingCircle(positions);
+			doNotOptimize(circle);
+		});
+	}
+}
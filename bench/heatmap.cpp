@@ -0,0 +1,27 @@
+#include "bench.hpp"
+#include "core/heatmap.hpp"
+
+using namespace dm;
+
+void bench::benchHeatmap() {
+	for (size_t count : { 10'000, 1'000'000 }) {
+		auto const positions = makePositions(count);
+		std::vector<float> xs, ys;
+		for (auto const& pos : positions) {
+			xs.push_back(pos.x);
+			ys.push_back(pos.y);
+		}
+
+		measure("binDeaths/" + std::to_string(count), 0, [&] {
+			auto grid = binDeaths(xs, ys, 15);
+			doNotOptimize(grid);
+		});
+
+		auto const grid = binDeaths(xs, ys, 15);
+		measure("rasterizeHeatmapTiles/" + std::to_string(count),
+			grid.counts.size() * 4, [&] {
+			auto tiles = rasterizeHeatmapTiles(grid);
+			doNotOptimize(tiles);
+		});
+	}
+}
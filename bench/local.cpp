@@ -0,0 +1,147 @@
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include "bench.hpp"
+#include "core/journal.hpp"
+#include "core/local.hpp"
+
+using namespace dm;
+
+namespace {
+
+	std::vector<std::string> legacySplit(std::string const& string, char at) {
+		auto result = std::vector<std::string>();
+		size_t currentStart = 0;
+
+		while (true) {
+			size_t nextSplit = string.find_first_of(at, currentStart);
+			if (nextSplit == std::string::npos) {
+				result.push_back(string.substr(currentStart));
+				return result;
+			}
+			result.push_back(string.substr(currentStart, nextSplit - currentStart));
+			currentStart = nextSplit + 1;
+		}
+	}
+
+	// Mirrors the previous split + stof line parser
+	std::optional<DeathEntry> legacyReadCSVLine(std::string const& buffer,
+		bool hasPercentage) {
+		if (buffer.empty()) return std::nullopt;
+
+		auto coords = legacySplit(buffer, ',');
+		bool isGhost = coords.size() > 3;
+		size_t expect = (hasPercentage ? 3 : 2) + (isGhost * 3);
+		if (coords.size() != expect) return std::nullopt;
+
+		DeathEntry entry;
+		try {
+			entry.pos.x = std::stof(coords.at(0));
+			entry.pos.y = std::stof(coords.at(1));
+			if (hasPercentage)
+				entry.percentage = std::stoi(coords.at(isGhost ? 5 : 2));
+			if (isGhost) {
+				GhostPose pose;
+				pose.rotation = std::stof(coords.at(2));
+				pose.mode = static_cast<int>(std::stof(coords.at(3)));
+				pose.setFlags(std::stoi(coords.at(4)));
+				entry.ghost = pose;
+			}
+		} catch (std::exception const&) {
+			return std::nullopt;
+		}
+		return entry;
+	}
+
+}
+
+void bench::benchLocal() {
+	auto const dir = std::filesystem::temp_directory_path() / "dm-bench";
+	std::filesystem::create_directories(dir);
+
+	for (bool ghost : { false, true }) {
+		size_t const count = 100'000;
+		std::mt19937 gen(7);
+		DeathStore deaths;
+		for (auto& pos : makePositions(count)) {
+			DeathEntry entry;
+			entry.pos = pos;
+			entry.percentage = static_cast<int>(pos.x / 300);
+			if (ghost) {
+				GhostPose pose;
+				pose.rotation = static_cast<float>(gen() % 360);
+				pose.mode = gen() % 9;
+				pose.setFlags(gen() % 16);
+				entry.ghost = pose;
+			}
+			deaths.push_back(entry);
+		}
+		// Saves are written from the sorted in-game list
+		deaths.sortByX();
+
+		auto const csvPath = dir / (ghost ? "ghost" : "plain");
+		auto const path = dir / (ghost ? "ghost.bin" : "plain.bin");
+		std::string const suffix = std::string(ghost ? "ghost/" : "plain/") +
+			std::to_string(count);
+
+		measure("writeLocalDeathsCSV/" + suffix, 0, [&] {
+			writeLocalDeathsCSV(csvPath, deaths, true);
+		});
+		measure("writeLocalDeaths/" + suffix, 0, [&] {
+			writeLocalDeaths(path, deaths, true);
+		});
+
+		// The writes may have been filtered out
+		writeLocalDeathsCSV(csvPath, deaths, true);
+		writeLocalDeaths(path, deaths, true);
+
+		measure("readLocalDeathsCSV/" + suffix,
+			std::filesystem::file_size(csvPath), [&] {
+				DeathStore loaded;
+				readLocalDeathsCSV(csvPath, true, &loaded);
+				doNotOptimize(loaded);
+			}
+		);
+		measure("readLocalDeaths/" + suffix, std::filesystem::file_size(path), [&] {
+			DeathStore loaded;
+			readLocalDeaths(path, &loaded);
+			doNotOptimize(loaded);
+		});
+
+		// Parsing alone, without file access
+		std::ostringstream csv;
+		for (size_t i = 0; i < deaths.size(); i++) {
+			printCSV(csv, deaths.entry(i), true);
+			csv << '\n';
+		}
+		auto const buffer = csv.str();
+
+		measure("readCSV/legacy/" + suffix, buffer.size(), [&] {
+			DeathStore loaded;
+			auto stream = std::istringstream(buffer);
+			std::string line;
+			while (std::getline(stream, line)) {
+				if (auto entry = legacyReadCSVLine(line, true)) loaded.push_back(*entry);
+			}
+			doNotOptimize(loaded);
+		});
+		measure("readCSV/from_chars/" + suffix, buffer.size(), [&] {
+			DeathStore loaded;
+			readCSVDeaths(buffer, true, &loaded);
+			doNotOptimize(loaded);
+		});
+
+		// Quitting after a session with a few hundred new deaths
+		auto const journalPath = dir / (ghost ? "ghost.journal" : "plain.journal");
+		measure("DeathJournal/append+close/500/" + suffix, 0, [&] {
+			std::filesystem::remove(journalPath);
+			DeathJournal journal;
+			journal.open(journalPath, deaths.size());
+			for (size_t i = 0; i < 500; i++) journal.append(deaths.entry(i));
+			journal.close();
+		});
+	}
+
+	std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "bench.hpp"
+
+using namespace dm;
+
+static char const* filter = nullptr;
+
+void bench::measure(std::string const& name, size_t bytes,
+	std::function<void()> const& fn) {
+	if (filter && name.find(filter) == std::string::npos) return;
+
+	using clock = std::chrono::steady_clock;
+	auto const minTime = std::chrono::milliseconds(250);
+
+	// Warm up caches and the allocator
+	fn();
+
+	size_t runs = 0;
+	auto const start = clock::now();
+	auto now = start;
+	do {
+		fn();
+		runs++;
+		now = clock::now();
+	} while (now - start < minTime);
+
+	double const seconds = std::chrono::duration<double>(now - start).count();
+	double const perRun = seconds / runs;
+
+	std::printf("%-48s %12.3f us/run", name.c_str(), perRun * 1e6);
+	if (bytes) std::printf(" %10.1f MB/s", bytes / perRun / 1e6);
+	std::printf("  (%zu runs)\n", runs);
+}
+
+std::vector<Vec2> bench::makePositions(size_t count, uint32_t seed) {
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<float> xDist(0, 30000);
+	std::normal_distribution<float> yDist(300, 120);
+
+	std::vector<Vec2> positions;
+	positions.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		positions.push_back({ xDist(gen), yDist(gen) });
+	return positions;
+}
+
+std::vector<uint8_t> bench::makeListBody(size_t count, bool hasPercentage,
+	uint32_t seed) {
+	size_t const elementWidth = hasPercentage ? 10 : 8;
+	std::vector<uint8_t> body(1 + count * elementWidth);
+	body[0] = 1;
+
+	auto positions = makePositions(count, seed);
+	for (size_t i = 0; i < count; i++) {
+		uint8_t* record = body.data() + 1 + i * elementWidth;
+		uint16_t percentage = static_cast<uint16_t>(positions[i].x / 300);
+		std::memcpy(record, &positions[i].x, 4);
+		std::memcpy(record + 4, &positions[i].y, 4);
+		if (hasPercentage) std::memcpy(record + 8, &percentage, 2);
+	}
+	return body;
+}
+
+std::vector<uint8_t> bench::makeAnalysisBody(size_t count, uint32_t seed) {
+	size_t const elementWidth = 32;
+	std::vector<uint8_t> body(1 + count * elementWidth);
+	body[0] = 1;
+
+	std::mt19937 gen(seed);
+	auto positions = makePositions(count, seed);
+	for (size_t i = 0; i < count; i++) {
+		uint8_t* record = body.data() + 1 + i * elementWidth;
+		// A few thousand players with many deaths each
+		uint32_t player = gen() % 4096;
+		for (int b = 0; b < 20; b++) record[b] = static_cast<uint8_t>(player >> (b % 4 * 8));
+		record[20] = 1;
+		record[21] = gen() % 2;
+		uint16_t percentage = static_cast<uint16_t>(positions[i].x / 300);
+		std::memcpy(record + 22, &positions[i].x, 4);
+		std::memcpy(record + 26, &positions[i].y, 4);
+		std::memcpy(record + 30, &percentage, 2);
+	}
+	return body;
+}
+
+std::vector<uint8_t> bench::makeAnalysisDictionaryBody(size_t count,
+	uint32_t seed) {
+	size_t const players = 4096;
+	size_t const elementWidth = 16;
+	size_t const recordStart = 5 + players * 20;
+	std::vector<uint8_t> body(recordStart + count * elementWidth);
+	body[0] = 2;
+	uint32_t const playerCount = players;
+	std::memcpy(body.data() + 1, &playerCount, 4);
+	for (uint32_t player = 0; player < players; player++) {
+		for (int b = 0; b < 20; b++)
+			body[5 + player * 20 + b] = static_cast<uint8_t>(player >> (b % 4 * 8));
+	}
+
+	std::mt19937 gen(seed);
+	auto positions = makePositions(count, seed);
+	for (size_t i = 0; i < count; i++) {
+		uint8_t* record = body.data() + recordStart + i * elementWidth;
+		uint32_t player = gen() % players;
+		uint16_t percentage = static_cast<uint16_t>(positions[i].x / 300);
+		std::memcpy(record, &player, 4);
+		record[4] = 1;
+		record[5] = gen() % 2;
+		std::memcpy(record + 6, &percentage, 2);
+		std::memcpy(record + 8, &positions[i].x, 4);
+		std::memcpy(record + 12, &positions[i].y, 4);
+	}
+	return body;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1) filter = argv[1];
+
+	bench::benchParsing();
+	bench::benchLocal();
+	bench::benchClustering();
+	bench::benchSpam();
+	bench::benchSearch();
+	bench::benchStore();
+	bench::benchHeatmap();
+
+	return 0;
+}
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cstring>
+#include "bench.hpp"
+#include "core/binary.hpp"
+#include "core/bulkDecode.hpp"
+#include "core/packedList.hpp"
+
+using namespace dm;
+
+namespace {
+
+	// Mirrors the previous record-by-record decode through a packed union
+	void legacyParseList(ByteSpan body, DeathStore* target) {
+		size_t const elementWidth = 10;
+		target->reserve(target->size() + (body.size() - 1) / elementWidth);
+		for (size_t off = 1; off + elementWidth <= body.size(); off += elementWidth) {
+#pragma pack(push, 1)
+			union stencil {
+				struct dmObj {
+					float x;
+					float y;
+					uint16_t perc;
+				} obj;
+				uint8_t raw[10];
+			} stencil{};
+#pragma pack(pop)
+
+			std::memcpy(stencil.raw, body.data() + off, elementWidth);
+			target->push_back({ stencil.obj.x, stencil.obj.y }, stencil.obj.perc);
+		}
+	}
+
+	struct LegacyAnalysisEntry {
+		Vec2 pos;
+		int percentage = 0;
+		std::string userIdent;
+		int levelVersion = 1;
+		bool practice = false;
+	};
+
+	void legacyParseAnalysis(ByteSpan body,
+		std::vector<LegacyAnalysisEntry>* target) {
+		size_t const elementWidth = analysisElementWidth;
+		target->reserve(target->size() + (body.size() - 1) / elementWidth);
+		for (size_t off = 1; off + elementWidth <= body.size(); off += elementWidth) {
+#pragma pack(push, 1)
+			union stencil {
+				struct dmObj {
+					uint8_t ident[20];
+					uint8_t levelversion;
+					uint8_t practice;
+					float x;
+					float y;
+					uint16_t perc;
+				} obj;
+				uint8_t raw[32];
+			} stencil{};
+#pragma pack(pop)
+
+			std::memcpy(stencil.raw, body.data() + off, elementWidth);
+
+			LegacyAnalysisEntry entry;
+			entry.pos = { stencil.obj.x, stencil.obj.y };
+			entry.userIdent = uint8ToHexString(stencil.obj.ident, 20);
+			entry.levelVersion = stencil.obj.levelversion;
+			entry.practice = stencil.obj.practice != 0;
+			entry.percentage = stencil.obj.perc;
+			target->push_back(std::move(entry));
+		}
+	}
+
+	char const* kernelName(DecodeKernel kernel) {
+		switch (kernel) {
+			case DecodeKernel::AVX2: return "avx2";
+			case DecodeKernel::SSE2: return "sse2";
+			default: return "scalar";
+		}
+	}
+
+}
+
+void bench::benchParsing() {
+	for (size_t count : { 10'000, 200'000 }) {
+		auto const body = makeListBody(count, true);
+		measure("parseBinDeathList/list/" + std::to_string(count), body.size(),
+			[&] {
+				DeathStore deaths;
+				parseBinDeathList(ByteSpan(body), &deaths, true);
+				doNotOptimize(deaths);
+			}
+		);
+	}
+
+	// Typical TCP segment and TLS record sizes
+	for (size_t chunkSize : { 1'460, 16'384 }) {
+		size_t const count = 200'000;
+		auto const body = makeListBody(count, true);
+		measure("BinListDecoder/list/" + std::to_string(count) + "/chunk" +
+			std::to_string(chunkSize), body.size(), [&] {
+				DeathStore deaths;
+				BinListDecoder decoder(&deaths, true);
+				decoder.setExpectedSize(body.size());
+				for (size_t off = 0; off < body.size(); off += chunkSize) {
+					decoder.feed(ByteSpan(body).subspan(off,
+						std::min(chunkSize, body.size() - off)));
+				}
+				decoder.finish();
+				doNotOptimize(deaths);
+			}
+		);
+	}
+
+	// Version 2 of the same lists
+	for (size_t count : { 10'000, 200'000 }) {
+		auto const body = makeListBody(count, true);
+		DeathStore deaths;
+		parseBinDeathList(ByteSpan(body), &deaths, true);
+		deaths.sortByX();
+		auto const packed = encodePackedList(deaths, true, 4);
+
+		measure("parseBinDeathList/packed/" + std::to_string(count), packed.size(),
+			[&] {
+				DeathStore deaths;
+				parseBinDeathList(ByteSpan(packed), &deaths, true);
+				doNotOptimize(deaths);
+			}
+		);
+	}
+
+	for (size_t count : { 10'000, 200'000 }) {
+		auto const body = makeAnalysisBody(count);
+		measure("parseBinDeathList/analysis/" + std::to_string(count),
+			body.size(), [&] {
+				AnalysisStore deaths;
+				parseBinDeathList(ByteSpan(body), &deaths);
+				doNotOptimize(deaths);
+			}
+		);
+
+		auto const dictionary = makeAnalysisDictionaryBody(count);
+		measure("parseBinDeathList/analysis-dictionary/" + std::to_string(count),
+			dictionary.size(), [&] {
+				AnalysisStore deaths;
+				parseBinDeathList(ByteSpan(dictionary), &deaths);
+				doNotOptimize(deaths);
+			}
+		);
+	}
+
+	// Bulk kernels against the previous per-record loop
+	size_t const count = 1'000'000;
+	auto const supported = getSupportedKernel();
+	auto const listBody = makeListBody(count, true);
+	auto const analysisBody = makeAnalysisBody(count);
+
+	measure("decode/list/1M/legacy", listBody.size(), [&] {
+		DeathStore deaths;
+		legacyParseList(ByteSpan(listBody), &deaths);
+		doNotOptimize(deaths);
+	});
+	measure("decode/analysis/1M/legacy", analysisBody.size(), [&] {
+		std::vector<LegacyAnalysisEntry> deaths;
+		legacyParseAnalysis(ByteSpan(analysisBody), &deaths);
+		doNotOptimize(deaths);
+	});
+
+	for (auto kernel : { DecodeKernel::Scalar, DecodeKernel::SSE2, DecodeKernel::AVX2 }) {
+		if (kernel > supported) break;
+		setDecodeKernel(kernel);
+
+		measure(std::string("decode/list/1M/") + kernelName(kernel),
+			listBody.size(), [&] {
+				DeathStore deaths;
+				parseBinDeathList(ByteSpan(listBody), &deaths, true);
+				doNotOptimize(deaths);
+			}
+		);
+		measure(std::string("decode/analysis/1M/") + kernelName(kernel),
+			analysisBody.size(), [&] {
+				AnalysisStore deaths;
+				parseBinDeathList(ByteSpan(analysisBody), &deaths);
+				doNotOptimize(deaths);
+			}
+		);
+	}
+
+	// Kernels alone, without allocating or interning, in batches the size
+	// parseBinDeathList uses
+	size_t const batch = 4096;
+	AnalysisStore columns;
+	auto out = columns.extend(batch);
+	std::vector<uint8_t> idents(batch * AnalysisStore::identWidth);
+	for (auto kernel : { DecodeKernel::Scalar, DecodeKernel::SSE2, DecodeKernel::AVX2 }) {
+		if (kernel > supported) break;
+		setDecodeKernel(kernel);
+
+		measure(std::string("decode/analysis-kernel/1M/") + kernelName(kernel),
+			analysisBody.size(), [&] {
+				size_t invalid = 0;
+				for (size_t done = 0; done < count; done += batch) {
+					invalid += decodeAnalysisRecords(
+						analysisBody.data() + 1 + done * analysisElementWidth,
+						std::min(batch, count - done), out, idents.data());
+				}
+				doNotOptimize(invalid);
+			}
+		);
+	}
+	setDecodeKernel(supported);
+}
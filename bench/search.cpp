@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <memory>
+#include <random>
+#include "bench.hpp"
+#include "core/chunkedStore.hpp"
+#include "core/search.hpp"
+
+using namespace dm;
+
+namespace {
+
+	// Mirrors the previous search, which projected every probed death
+	// through xOf
+	template <typename Projection>
+	size_t legacyNearestXPos(size_t from, size_t to, float x,
+		bool preferHigher, Projection xOf) {
+
+		while (to - from > 1) {
+			auto middle = from + ((to - from) / 2);
+
+			if (xOf(middle) > x) to = middle;
+			else from = middle;
+		}
+
+		return preferHigher ? to : from;
+
+	}
+
+	// Stands in for the node's transform applied at every probe, held
+	// behind a pointer like in cocos
+	struct AffineTransform {
+		float a, b, c, d, tx, ty;
+	};
+
+}
+
+void bench::benchSearch() {
+	size_t const count = 1'000'000;
+	auto positions = makePositions(count);
+	std::sort(positions.begin(), positions.end(),
+		[](Vec2 const& a, Vec2 const& b) { return a.x < b.x; });
+	std::vector<float> keys(count);
+	for (size_t i = 0; i < count; i++) keys[i] = positions[i].x;
+
+	std::mt19937 gen(3);
+	std::uniform_real_distribution<float> dist(0, 30000);
+	std::vector<float> queries(4096);
+	for (auto& query : queries) query = dist(gen);
+	std::string const suffix = "/" + std::to_string(count) + "x4096";
+
+	auto transform = std::make_unique<AffineTransform>(
+		AffineTransform{ 0.8f, 0.1f, -0.1f, 0.8f, -1200, 40 });
+	measure("search/legacy+transform" + suffix, 0, [&] {
+		size_t sum = 0;
+		for (float query : queries) {
+			sum += legacyNearestXPos(0, positions.size(), query, true,
+				[&positions, &transform](size_t index) {
+					auto const& pos = positions[index];
+					return transform->a * pos.x + transform->c * pos.y + transform->tx;
+				});
+		}
+		doNotOptimize(sum);
+	});
+
+	measure("search/legacy" + suffix, 0, [&] {
+		size_t sum = 0;
+		for (float query : queries) {
+			sum += legacyNearestXPos(0, positions.size(), query, true,
+				[&positions](size_t index) { return positions[index].x; });
+		}
+		doNotOptimize(sum);
+	});
+
+	measure("search/std::upper_bound" + suffix, 0, [&] {
+		size_t sum = 0;
+		for (float query : queries)
+			sum += std::upper_bound(keys.begin(), keys.end(), query) - keys.begin();
+		doNotOptimize(sum);
+	});
+
+	measure("search/branchless" + suffix, 0, [&] {
+		size_t sum = 0;
+		for (float query : queries) sum += upperBoundBranchless(keys, query);
+		doNotOptimize(sum);
+	});
+
+	// A chunk of ChunkedDeathStore, which stays in cache between searches
+	std::vector<float> chunk(keys.begin(), keys.begin() + ChunkedDeathStore::chunkCapacity);
+	std::uniform_real_distribution<float> chunkDist(0, chunk.back());
+	std::vector<float> chunkQueries(4096);
+	for (auto& query : chunkQueries) query = chunkDist(gen);
+	std::string const chunkSuffix = "/" + std::to_string(chunk.size()) + "x4096";
+
+	measure("search/std::upper_bound" + chunkSuffix, 0, [&] {
+		size_t sum = 0;
+		for (float query : chunkQueries)
+			sum += std::upper_bound(chunk.begin(), chunk.end(), query) - chunk.begin();
+		doNotOptimize(sum);
+	});
+
+	measure("search/branchless" + chunkSuffix, 0, [&] {
+		size_t sum = 0;
+		for (float query : chunkQueries) sum += upperBoundBranchless(chunk, query);
+		doNotOptimize(sum);
+	});
+
+	DeathStore store;
+	store.reserve(count);
+	for (auto& pos : positions) store.push_back(pos, 0);
+	ChunkedDeathStore chunked;
+	chunked.merge(store);
+	measure("search/chunked" + suffix, 0, [&] {
+		size_t sum = 0;
+		for (float query : queries) sum += chunked.upperBound(query);
+		doNotOptimize(sum);
+	});
+}
@@ -0,0 +1,21 @@
+#include "bench.hpp"
+#include "core/spam.hpp"
+
+using namespace dm;
+
+void bench::benchSpam() {
+	size_t const count = 10'000;
+	std::vector<DeathLocationOut> submissions;
+	std::time_t time = 0;
+	for (auto& pos : makePositions(count)) {
+		DeathLocationOut death(pos);
+		death.realTime = time += 2;
+		submissions.push_back(death);
+	}
+
+	measure("purgeSpam/" + std::to_string(count), 0, [&] {
+		auto copy = submissions;
+		purgeSpam(copy);
+		doNotOptimize(copy);
+	});
+}
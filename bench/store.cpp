@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <memory>
+#include "bench.hpp"
+#include "core/chunkedStore.hpp"
+#include "core/deathStore.hpp"
+
+using namespace dm;
+
+namespace {
+
+	// Mirrors the previous per-death heap objects in DMPlayLayer
+	struct LegacyDeath {
+		float x;
+		float y;
+		int percentage;
+		LegacyDeath(float x, float y, int percentage) :
+			x(x), y(y), percentage(percentage) {}
+		virtual ~LegacyDeath() = default;
+	};
+
+}
+
+void bench::benchStore() {
+	size_t const count = 200'000;
+	auto const positions = makePositions(count);
+
+	measure("store/build+sort/legacy/" + std::to_string(count), 0, [&] {
+		std::vector<std::unique_ptr<LegacyDeath>> deaths;
+		deaths.reserve(count);
+		for (auto& pos : positions)
+			deaths.push_back(std::make_unique<LegacyDeath>(pos.x, pos.y,
+				static_cast<int>(pos.x / 300)));
+		std::sort(deaths.begin(), deaths.end(), [](auto& a, auto& b) {
+			return a->x < b->x;
+		});
+		doNotOptimize(deaths);
+	});
+
+	measure("store/build+sort/columnar/" + std::to_string(count), 0, [&] {
+		DeathStore deaths;
+		deaths.reserve(count);
+		for (auto& pos : positions)
+			deaths.push_back(pos, static_cast<int>(pos.x / 300));
+		deaths.sortByX();
+		doNotOptimize(deaths);
+	});
+
+	std::vector<std::unique_ptr<LegacyDeath>> legacy;
+	DeathStore store;
+	for (auto& pos : positions) {
+		legacy.push_back(std::make_unique<LegacyDeath>(pos.x, pos.y,
+			static_cast<int>(pos.x / 300)));
+		store.push_back(pos, static_cast<int>(pos.x / 300));
+	}
+	// Shuffled allocation order is what a sort leaves behind
+	std::sort(legacy.begin(), legacy.end(), [](auto& a, auto& b) {
+		return a->x < b->x;
+	});
+	store.sortByX();
+
+	measure("store/histogram/legacy/" + std::to_string(count), 0, [&] {
+		int hist[101] = { 0 };
+		for (auto& death : legacy)
+			if (death->percentage >= 0 && death->percentage < 101)
+				hist[death->percentage]++;
+		doNotOptimize(hist);
+	});
+
+	measure("store/histogram/columnar/" + std::to_string(count), 0, [&] {
+		int hist[101] = { 0 };
+		for (int percentage : store.percentages())
+			if (percentage >= 0 && percentage < 101)
+				hist[percentage]++;
+		doNotOptimize(hist);
+	});
+
+	// Adding a delta of new deaths to the full list
+	size_t const delta = 2'000;
+	auto const added = makePositions(delta, 2);
+	DeathStore fresh;
+	for (auto& pos : added) fresh.push_back(pos, static_cast<int>(pos.x / 300));
+
+	measure("store/add" + std::to_string(delta) + "/append+sort/" +
+		std::to_string(count), 0, [&] {
+			DeathStore deaths = store;
+			deaths.append(fresh);
+			deaths.sortByX();
+			doNotOptimize(deaths);
+		}
+	);
+
+	measure("store/add" + std::to_string(delta) + "/sort+merge/" +
+		std::to_string(count), 0, [&] {
+			DeathStore deaths = store;
+			DeathStore sorted = fresh;
+			sorted.sortByX();
+			deaths.merge(sorted);
+			doNotOptimize(deaths);
+		}
+	);
+
+	// Deaths of the current session, each inserted in place and erased again
+	// so the store keeps its size between runs
+	auto const session = makePositions(256, 3);
+	ChunkedDeathStore chunked;
+	chunked.merge(store);
+
+	measure("store/insert+erase256/columnar/" + std::to_string(count), 0, [&] {
+		for (auto& pos : session) {
+			size_t index = store.insert(pos, 0);
+			store.erase(index, index + 1);
+		}
+		doNotOptimize(store);
+	});
+
+	measure("store/insert+erase256/chunked/" + std::to_string(count), 0, [&] {
+		for (auto& pos : session) {
+			size_t index = chunked.indexOf(chunked.insert(pos, 0));
+			chunked.erase(index, index + 1);
+		}
+		doNotOptimize(chunked);
+	});
+}
@@ -1,17 +1,17 @@
 module.exports = {
   list: async (levelId, isPlatformer, inclPractice) => {
     return {
-      columns: isPlatformer
-        ? "x,y"
-        : "x,y,percentage",
+      columns: "x,y,percentage",
       deaths: [
         isPlatformer
-          ? [100.0, 200.0]
+          ? [100.0, 200.0, 12]
           : [100.0, 200.0, 37]
       ]
     };
   },
 
+  cursor: async () => 1,
+
   analyze: async () => {
     return [];
   },
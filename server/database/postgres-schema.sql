@@ -22,3 +22,14 @@ CREATE TABLE IF NOT EXISTS format2 (
 
 CREATE INDEX IF NOT EXISTS format1index ON format1 (levelid);
 CREATE INDEX IF NOT EXISTS format2index ON format2 (levelid);
+
+-- Shared across both tables, so a single cursor covers a whole level
+CREATE SEQUENCE IF NOT EXISTS deathid;
+ALTER TABLE format1 ADD COLUMN IF NOT EXISTS id BIGINT NOT NULL DEFAULT nextval('deathid');
+ALTER TABLE format2 ADD COLUMN IF NOT EXISTS id BIGINT NOT NULL DEFAULT nextval('deathid');
+CREATE INDEX IF NOT EXISTS format1cursor ON format1 (levelid, id);
+CREATE INDEX IF NOT EXISTS format2cursor ON format2 (levelid, id);
+
+-- Lets x range (paged) listings skip the rest of a level
+CREATE INDEX IF NOT EXISTS format1range ON format1 (levelid, x);
+CREATE INDEX IF NOT EXISTS format2range ON format2 (levelid, x);
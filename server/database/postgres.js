@@ -27,18 +27,23 @@ try {
 
 module.exports = {
 
-  list: async (levelId, isPlatformer, inclPractice) => {
-
-    let columns = isPlatformer ? "x,y" : "x,y,percentage";
-    let where = "WHERE levelid = $1"
-      + (isPlatformer ? " AND percentage < 101" : "");
+  // Only deaths with since < id <= until and xmin <= x < xmax are listed
+  list: async (levelId, isPlatformer, inclPractice, since, until,
+    xmin = -Infinity, xmax = Infinity) => {
+
+    // Platformer levels store the attempt time in place of the percentage
+    let columns = "x,y,percentage";
+    // Platformer times of death may well be past 100 seconds
+    let where = "WHERE levelid = $1 AND id > $2 AND id <= $3 AND x >= $4 AND x < $5";
     let query = `SELECT ${columns} FROM format1 ${where}${inclPractice ? "" : " AND practice = false"} ` +
-      `UNION SELECT ${columns} FROM format2 ${where}${inclPractice ? "" : " AND practice = false"};`;
+      `UNION SELECT ${columns} FROM format2 ${where}${inclPractice ? "" : " AND practice = false"} ` +
+      // Sorted so clients decoding while downloading get the start of the level first
+      `ORDER BY x;`;
 
     return {
       deaths: (await db.query({
         text: query,
-        values: [levelId],
+        values: [levelId, since, until, xmin, xmax],
         rowMode: "array"
       })).rows,
       columns
@@ -46,11 +51,26 @@ module.exports = {
 
   },
 
-  analyze: async (levelId, columns) => {
+  // Highest death id of a level. Ids only grow, so it identifies a version
+  // of everything stored for the level.
+  cursor: async (levelId) => {
+
+    let query = "SELECT GREATEST(" +
+      "(SELECT max(id) FROM format1 WHERE levelid = $1), " +
+      "(SELECT max(id) FROM format2 WHERE levelid = $1), 0) AS cursor;";
+
+    return (await db.query({
+      text: query,
+      values: [levelId]
+    })).rows[0].cursor;
+
+  },
+
+  analyze: async (levelId, columns, since, until) => {
 
     return (await db.query({
-      text: `SELECT ${columns} FROM format1 WHERE levelid = $1;`,
-      values: [levelId],
+      text: `SELECT ${columns} FROM format1 WHERE levelid = $1 AND id > $2 AND id <= $3;`,
+      values: [levelId, since, until],
       rowMode: "array"
     })).rows;
 
@@ -13,9 +13,13 @@ const {
 const PORT = 8048;
 const BUFFER_SIZE = 500; // # of deaths to push at once
 const BINARY_VERSION = 1; // Incremental
-const alphabet = "ABCDEFGHIJOKLMNOPQRSTUVWXYZabcdefghijoklmnopqrstuvwxyz0123456789";
-const random = l => new Array(l).fill(0)
-  .map(_ => alphabet[Math.floor(Math.random() * alphabet.length)]).join("");
+const PACKED_VERSION = 2; // Versioning byte of response=bin2
+const PACKED_SCALE = 4; // Grid steps per unit positions are rounded to
+const PACKED_BLOCK = 128; // Deaths per bit-packed block
+const ANALYSIS_DICTIONARY_VERSION = 2; // Versioning byte of /analysis response=bin2
+// Analysis salts are derived from this, so idents of a level stay the same
+// across requests (and deltas of it) until the server restarts
+const SALT_SECRET = require("crypto").randomBytes(32);
 
 console.log("DATABASE_DRIVER =", DATABASE_DRIVER);
 
@@ -114,6 +118,108 @@ function binaryStream(array, columns, map = r => r) {
   })
 }
 
+// Deaths as a version 2 binary list, see "Binary transmission" in docs/doc.md
+function packedStream(array, columns) {
+  const hasPercentage = columns.split(",").includes("percentage");
+  const rows = array.slice().sort((a, b) => a[0] - b[0]);
+  const bytes = [];
+
+  const varint = v => {
+    while (v >= 0x80) {
+      bytes.push(v % 0x80 + 0x80);
+      v = Math.floor(v / 0x80);
+    }
+    bytes.push(v);
+  };
+  const zigzag = v => v >= 0 ? v * 2 : -v * 2 - 1;
+  const width = values => {
+    const max = Math.max(...values);
+    return max ? Math.floor(Math.log2(max)) + 1 : 0;
+  };
+  // Little endian bit stream, padded to a whole byte
+  const pack = (values, w) => {
+    let acc = 0, bits = 0;
+    for (const v of values) {
+      acc += v * 2 ** bits;
+      bits += w;
+      while (bits >= 8) {
+        bytes.push(acc % 256);
+        acc = Math.floor(acc / 256);
+        bits -= 8;
+      }
+    }
+    if (bits) bytes.push(acc);
+  };
+
+  const q = rows.map(r => [
+    Math.round(r[0] * PACKED_SCALE),
+    Math.round(r[1] * PACKED_SCALE),
+    hasPercentage ? r[2] : 0
+  ]);
+  let [x, y, p] = [q.length ? q[0][0] : 0, 0, 0];
+
+  bytes.push(PACKED_VERSION, hasPercentage ? 1 : 0);
+  varint(PACKED_SCALE);
+  varint(q.length);
+  varint(zigzag(x));
+
+  for (let start = 0; start < q.length; start += PACKED_BLOCK) {
+    const block = q.slice(start, start + PACKED_BLOCK);
+    const dx = [], dy = [], dp = [];
+    for (const [qx, qy, qp] of block) {
+      dx.push(qx - x);
+      dy.push(zigzag(qy - y));
+      dp.push(zigzag(qp - p));
+      [x, y, p] = [qx, qy, qp];
+    }
+    const columns = hasPercentage ? [dx, dy, dp] : [dx, dy];
+    const widths = columns.map(width);
+    bytes.push(...widths);
+    columns.forEach((c, i) => pack(c, widths[i]));
+  }
+
+  return Readable.from([Buffer.from(bytes)]);
+}
+
+// Analysis rows as version 2 binary, sending each ident once in a dictionary
+// and referring to it by index from every death
+function analysisDictionaryStream(array, map) {
+  const players = new Map();
+  const records = Buffer.alloc(array.length * 16);
+  array.forEach((row, i) => {
+    const [ident, levelversion, practice, x, y, percentage] = map(row);
+    let player = players.get(ident);
+    if (player === undefined) players.set(ident, player = players.size);
+
+    const o = i * 16;
+    records.writeUInt32LE(player, o);
+    records.writeUInt8(levelversion, o + 4);
+    records.writeUInt8(practice, o + 5);
+    records.writeUInt16LE(percentage, o + 6);
+    records.writeFloatLE(x, o + 8);
+    records.writeFloatLE(y, o + 12);
+  });
+
+  const header = Buffer.alloc(5);
+  header.writeUInt8(ANALYSIS_DICTIONARY_VERSION);
+  header.writeUInt32LE(players.size, 1);
+  const idents = [...players.keys()].map(ident => Buffer.from(ident, "hex"));
+  return Readable.from([Buffer.concat([header, ...idents, records])]);
+}
+
+// Reads the optional since cursor of a listing request and tells the client
+// which deaths the response covers. Clients only treat the response as an
+// addition to what they have if X-Death-Since matches the cursor they sent.
+function parseSince(req, res, cursor) {
+  let since = 0;
+  if (/^\d+$/.test(req.query.since || "")) {
+    since = req.query.since;
+    res.set("X-Death-Since", since);
+  }
+  res.set("X-Death-Cursor", String(cursor));
+  return since;
+}
+
 function renderGuide(fn) {
   console.log(`Rendering guide ${fn}...`);
   let markdown = fs.readFileSync(`./pages/${fn}`, "utf8");
@@ -181,12 +287,26 @@ app.get("/list", rateLimit, async (req, res) => {
   const inclPractice = practice !== "false" && practice !== "0";
 
   let accept = req.query.response || "csv";
-  if (accept != "csv" && accept != "bin") return res.sendStatus(400);
+  if (accept != "csv" && accept != "bin" && accept != "bin2") return res.sendStatus(400);
+
+  // Optional x range, lets clients fetch long levels page by page
+  const ranged = req.query.xmin !== undefined || req.query.xmax !== undefined;
+  const xmin = req.query.xmin === undefined ? -Infinity : parseFloat(req.query.xmin);
+  const xmax = req.query.xmax === undefined ? Infinity : parseFloat(req.query.xmax);
+  if (isNaN(xmin) || isNaN(xmax)) return res.sendStatus(400);
+
+  const cursor = await db.cursor(levelId);
+  const etag = `"${accept}${BINARY_VERSION}-${cursor}${ranged ? `-${xmin}-${xmax}` : ""}"`;
+  res.set("ETag", etag);
+  res.set("Cache-Control", "no-cache");
+  if (req.get("If-None-Match") === etag) return res.sendStatus(304);
 
-  let { deaths, columns } = await db.list(levelId, isPlatformer, inclPractice);
+  const since = parseSince(req, res, cursor);
+  let { deaths, columns } = await db.list(levelId, isPlatformer, inclPractice,
+    since, cursor, xmin, xmax);
 
   res.contentType(accept == "csv" ? "text/csv" : "application/octet-stream");
-  (accept == "csv" ? csvStream : binaryStream)(deaths, columns).pipe(res);
+  ({ csv: csvStream, bin: binaryStream, bin2: packedStream })[accept](deaths, columns).pipe(res);
 });
 
 app.get("/analysis", rateLimit, async (req, res) => {
@@ -195,21 +315,29 @@ app.get("/analysis", rateLimit, async (req, res) => {
   let levelId = parseInt(req.query.levelid);
 
   let accept = req.query.response || "csv";
-  if (accept != "csv" && accept != "bin") return res.sendStatus(400);
+  if (accept != "csv" && accept != "bin" && accept != "bin2") return res.sendStatus(400);
 
   let columns = "userident,levelversion,practice,x,y,percentage";
-  let salt = "_" + random(10);
-
-  let deaths = await db.analyze(levelId, columns);
+  let salt = "_" + crypto.createHmac("sha256", SALT_SECRET)
+    .update(String(levelId)).digest("base64url").slice(0, 10);
+  // Players die many times, hash each of them once
+  const salted = new Map();
+  const saltIdent = ident => {
+    if (!salted.has(ident))
+      salted.set(ident, crypto.createHash("sha1").update(ident + salt).digest("hex"));
+    return salted.get(ident);
+  };
+
+  const cursor = await db.cursor(levelId);
+  const since = parseSince(req, res, cursor);
+  let deaths = await db.analyze(levelId, columns, since, cursor);
 
   res.contentType(accept == "csv" ? "text/csv" : "application/octet-stream");
 
-  (accept == "csv" ? csvStream : binaryStream)(deaths, columns,
-    d => ([
-      crypto.createHash("sha1")
-        .update(d[0] + salt).digest("hex"),
-      ...d.slice(1)
-    ])
+  const map = d => [saltIdent(d[0]), ...d.slice(1)];
+  (accept == "bin2"
+    ? analysisDictionaryStream(deaths, map)
+    : (accept == "csv" ? csvStream : binaryStream)(deaths, columns, map)
   ).pipe(res);
 });
 
@@ -253,12 +381,16 @@ app.all("/submit", rateLimit, expr.text({
       deaths = [req.body]
     else deaths = req.body.deaths;
 
+    // Platformer levels store the time of death in seconds, which only has
+    // to fit the SMALLINT column and the 16 bit binary list format
+    const maxPercentage = req.body.platformer === true ? 32767 : 99;
+
     for (i = 0; i < deaths.length; i++) {
       deaths[i].practice = (!!deaths[i].practice) * 1;
 
       if (typeof deaths[i].percentage != "number")
         return res.status(400).send("percentage was not supplied or not numerical");
-      deaths[i].percentage = Math.min(99, Math.max(0, deaths[i].percentage));
+      deaths[i].percentage = Math.min(maxPercentage, Math.max(0, deaths[i].percentage));
 
       if (typeof deaths[i].x != "number")
         return res.status(400).send("x was not supplied or not numerical");
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstring>
+#include "analysisStore.hpp"
+#include "binary.hpp"
+
+using namespace dm;
+
+void AnalysisStore::clear() {
+	this->m_player.clear();
+	this->m_x.clear();
+	this->m_y.clear();
+	this->m_percentage.clear();
+	this->m_levelVersion.clear();
+	this->m_practice.clear();
+	this->m_playerIdent.clear();
+	this->m_playerSlots.clear();
+}
+
+void AnalysisStore::reserve(size_t count) {
+	this->m_player.reserve(count);
+	this->m_x.reserve(count);
+	this->m_y.reserve(count);
+	this->m_percentage.reserve(count);
+	this->m_levelVersion.reserve(count);
+	this->m_practice.reserve(count);
+}
+
+void AnalysisStore::truncate(size_t count) {
+	if (count >= this->size()) return;
+	this->m_player.resize(count);
+	this->m_x.resize(count);
+	this->m_y.resize(count);
+	this->m_percentage.resize(count);
+	this->m_levelVersion.resize(count);
+	this->m_practice.resize(count);
+}
+
+std::string AnalysisStore::userIdent(size_t index) const {
+	return uint8ToHexString(this->ident(index).data(), identWidth);
+}
+
+ByteSpan AnalysisStore::playerIdent(uint32_t player) const {
+	return ByteSpan(this->m_playerIdent).subspan(player * identWidth, identWidth);
+}
+
+static size_t identHash(uint8_t const* ident) {
+	uint64_t hash;
+	std::memcpy(&hash, ident, sizeof(hash));
+	return static_cast<size_t>(hash);
+}
+
+uint32_t AnalysisStore::internPlayer(uint8_t const* ident) {
+	// Kept at most half full
+	if ((this->playerCount() + 1) * 2 > this->m_playerSlots.size())
+		this->growPlayerSlots();
+
+	size_t const mask = this->m_playerSlots.size() - 1;
+	for (size_t slot = identHash(ident) & mask; ; slot = (slot + 1) & mask) {
+		uint32_t player = this->m_playerSlots[slot];
+		if (player == UINT32_MAX) {
+			player = static_cast<uint32_t>(this->playerCount());
+			this->m_playerSlots[slot] = player;
+			this->m_playerIdent.insert(this->m_playerIdent.end(), ident,
+				ident + identWidth);
+			return player;
+		}
+		if (std::memcmp(this->m_playerIdent.data() + player * identWidth, ident,
+			identWidth) == 0)
+			return player;
+	}
+}
+
+void AnalysisStore::growPlayerSlots() {
+	size_t const size = std::max<size_t>(64, this->m_playerSlots.size() * 2);
+	this->m_playerSlots.assign(size, UINT32_MAX);
+
+	size_t const mask = size - 1;
+	for (uint32_t player = 0; player < this->playerCount(); player++) {
+		size_t slot = identHash(this->m_playerIdent.data() + player * identWidth) & mask;
+		while (this->m_playerSlots[slot] != UINT32_MAX) slot = (slot + 1) & mask;
+		this->m_playerSlots[slot] = player;
+	}
+}
+
+AnalysisStore::Columns AnalysisStore::extend(size_t count) {
+	size_t const start = this->size();
+	this->m_player.resize(start + count);
+	this->m_x.resize(start + count);
+	this->m_y.resize(start + count);
+	this->m_percentage.resize(start + count);
+	this->m_levelVersion.resize(start + count);
+	this->m_practice.resize(start + count);
+
+	return {
+		this->m_player.data() + start,
+		this->m_x.data() + start,
+		this->m_y.data() + start,
+		this->m_percentage.data() + start,
+		this->m_levelVersion.data() + start,
+		this->m_practice.data() + start
+	};
+}
+
+template <typename T>
+static void appendColumn(std::vector<T>& column, std::vector<T> const& other) {
+	column.insert(column.end(), other.begin(), other.end());
+}
+
+void AnalysisStore::append(AnalysisStore const& other) {
+	// Player indices of other mapped to the ones in this store
+	std::vector<uint32_t> players(other.playerCount());
+	for (uint32_t i = 0; i < players.size(); i++)
+		players[i] = this->internPlayer(other.playerIdent(i).data());
+
+	this->m_player.reserve(this->size() + other.size());
+	for (uint32_t player : other.m_player) this->m_player.push_back(players[player]);
+	appendColumn(this->m_x, other.m_x);
+	appendColumn(this->m_y, other.m_y);
+	appendColumn(this->m_percentage, other.m_percentage);
+	appendColumn(this->m_levelVersion, other.m_levelVersion);
+	appendColumn(this->m_practice, other.m_practice);
+}
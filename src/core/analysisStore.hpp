@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "model.hpp"
+
+namespace dm {
+
+	// Columnar list of what the server sends for analysis, in the order it
+	// was received. User identifiers are interned: every death refers to a
+	// player index, and each distinct identifier is stored once as raw bytes.
+	class AnalysisStore {
+	public:
+		static constexpr size_t identWidth = 20;
+
+		// Mutable columns of a range of deaths, see extend
+		struct Columns {
+			uint32_t* player;
+			float* x;
+			float* y;
+			int* percentage;
+			uint8_t* levelVersion;
+			uint8_t* practice;
+		};
+
+		size_t size() const { return this->m_x.size(); }
+		bool empty() const { return this->m_x.empty(); }
+		void clear();
+		void reserve(size_t count);
+		// Drops all deaths from index count onwards, players stay interned
+		void truncate(size_t count);
+
+		float x(size_t index) const { return this->m_x[index]; }
+		float y(size_t index) const { return this->m_y[index]; }
+		Vec2 pos(size_t index) const { return { this->m_x[index], this->m_y[index] }; }
+		int percentage(size_t index) const { return this->m_percentage[index]; }
+		int levelVersion(size_t index) const { return this->m_levelVersion[index]; }
+		bool practice(size_t index) const { return this->m_practice[index] != 0; }
+		uint32_t player(size_t index) const { return this->m_player[index]; }
+		ByteSpan ident(size_t index) const { return this->playerIdent(this->m_player[index]); }
+		// Lowercase hex representation of ident
+		std::string userIdent(size_t index) const;
+
+		size_t playerCount() const { return this->m_playerIdent.size() / identWidth; }
+		ByteSpan playerIdent(uint32_t player) const;
+		// Returns the index of the player with this identWidth byte ident,
+		// adding it if it was not seen before
+		uint32_t internPlayer(uint8_t const* ident);
+
+		std::span<float const> xs() const { return this->m_x; }
+		std::span<float const> ys() const { return this->m_y; }
+		std::span<int const> percentages() const { return this->m_percentage; }
+		std::span<uint32_t const> players() const { return this->m_player; }
+
+		// Appends count zeroed deaths for bulk decoders to fill in place
+		Columns extend(size_t count);
+		void append(AnalysisStore const& other);
+
+	private:
+		std::vector<uint32_t> m_player;
+		std::vector<float> m_x;
+		std::vector<float> m_y;
+		std::vector<int> m_percentage;
+		std::vector<uint8_t> m_levelVersion;
+		// Raw byte as received, anything but 0 or 1 hints at misalignment
+		std::vector<uint8_t> m_practice;
+		// identWidth bytes per player
+		std::vector<uint8_t> m_playerIdent;
+		// Open addressing table of player indices by ident, UINT32_MAX marks
+		// an empty slot. Idents are salted hashes, so their first bytes
+		// already make a good hash.
+		std::vector<uint32_t> m_playerSlots;
+
+		void growPlayerSlots();
+	};
+
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cstring>
+#include "binary.hpp"
+#include "bulkDecode.hpp"
+
+using namespace dm;
+
+// Checks the versioning byte and alignment shared by all binary responses
+static ParseResult checkBody(ByteSpan body, size_t elementWidth) {
+	ParseResult result;
+	result.elementWidth = elementWidth;
+	if (body.size() <= elementWidth) {
+		result.status = ParseStatus::TooShort;
+		return result;
+	}
+
+	result.version = body[0];
+	result.count = (body.size() - 1) / elementWidth;
+	result.excess = (body.size() - 1) % elementWidth;
+
+	if (result.version != 1) result.status = ParseStatus::UnknownVersion;
+	else if (result.excess) result.status = ParseStatus::Misaligned;
+	return result;
+}
+
+ParseResult dm::parseBinDeathList(ByteSpan body,
+	DeathStore* target, bool hasPercentage) {
+
+	BinListDecoder decoder(target, hasPercentage);
+	decoder.setExpectedSize(body.size());
+	decoder.feed(body);
+	return decoder.finish();
+}
+
+// Offsets the columns of a decoded range by count deaths
+static AnalysisStore::Columns advance(AnalysisStore::Columns columns,
+	size_t count) {
+	return {
+		columns.player + count,
+		columns.x + count,
+		columns.y + count,
+		columns.percentage + count,
+		columns.levelVersion + count,
+		columns.practice + count
+	};
+}
+
+// Version 2 sends every ident once up front and refers to it by index
+static ParseResult parseAnalysisDictionary(ByteSpan body,
+	AnalysisStore* target) {
+
+	ParseResult result;
+	result.version = body[0];
+	result.elementWidth = analysisDictionaryElementWidth;
+
+	uint32_t playerCount = 0;
+	if (body.size() >= 5) std::memcpy(&playerCount, body.data() + 1, 4);
+	// Compared before multiplying, which can wrap where size_t is 32 bits
+	if (body.size() < 5 ||
+		playerCount > (body.size() - 5) / AnalysisStore::identWidth) {
+		result.status = ParseStatus::TooShort;
+		return result;
+	}
+	size_t const recordStart = 5 + size_t(playerCount) * AnalysisStore::identWidth;
+
+	auto records = body.subspan(recordStart);
+	result.count = records.size() / analysisDictionaryElementWidth;
+	result.excess = records.size() % analysisDictionaryElementWidth;
+	if (result.excess) {
+		result.status = ParseStatus::Misaligned;
+		return result;
+	}
+
+	size_t const start = target->size();
+	auto out = target->extend(result.count);
+	uint8_t const* record = records.data();
+	for (size_t i = 0; i < result.count; i++,
+		record += analysisDictionaryElementWidth) {
+
+		uint32_t player;
+		uint16_t percentage;
+		std::memcpy(&player, record, 4);
+		std::memcpy(&percentage, record + 6, 2);
+		std::memcpy(out.x + i, record + 8, 4);
+		std::memcpy(out.y + i, record + 12, 4);
+		if (player >= playerCount) {
+			result.status = ParseStatus::Malformed;
+			target->truncate(start);
+			return result;
+		}
+		out.player[i] = player;
+		out.levelVersion[i] = record[4];
+		out.practice[i] = record[5];
+		if (record[5] > 1) result.invalidPractice++;
+		out.percentage[i] = percentage;
+	}
+
+	// Idents are only interned once the whole body is known to be valid, so
+	// a failed parse leaves no players behind. Indices in this response are
+	// then mapped to the ones of the store.
+	std::vector<uint32_t> players(playerCount);
+	for (uint32_t i = 0; i < playerCount; i++) {
+		players[i] = target->internPlayer(body.data() + 5 +
+			i * AnalysisStore::identWidth);
+	}
+	for (size_t i = 0; i < result.count; i++)
+		out.player[i] = players[out.player[i]];
+	return result;
+}
+
+ParseResult dm::parseBinDeathList(ByteSpan body, AnalysisStore* target) {
+
+	if (!body.empty() && body[0] == analysisDictionaryVersion)
+		return parseAnalysisDictionary(body, target);
+
+	auto result = checkBody(body, analysisElementWidth);
+	if (result.status != ParseStatus::Ok) return result;
+
+	// Idents are decoded into a small buffer and interned batch by batch
+	size_t const batch = 4096;
+	std::vector<uint8_t> idents(std::min(batch, result.count) *
+		AnalysisStore::identWidth);
+
+	target->reserve(target->size() + result.count);
+	auto out = target->extend(result.count);
+	for (size_t done = 0; done < result.count; done += batch) {
+		size_t const count = std::min(batch, result.count - done);
+		auto columns = advance(out, done);
+		result.invalidPractice += decodeAnalysisRecords(
+			body.data() + 1 + done * analysisElementWidth, count, columns,
+			idents.data());
+		for (size_t i = 0; i < count; i++) {
+			columns.player[i] = target->internPlayer(idents.data() +
+				i * AnalysisStore::identWidth);
+		}
+	}
+	return result;
+}
+
+std::string dm::uint8ToHexString(uint8_t const* v, size_t s) {
+	static constexpr char digits[] = "0123456789abcdef";
+	std::string result(s * 2, '0');
+
+	for (size_t i = 0; i < s; i++) {
+		result[i * 2] = digits[v[i] >> 4];
+		result[i * 2 + 1] = digits[v[i] & 0xf];
+	}
+
+	return result;
+}
+
+
+BinListDecoder::BinListDecoder(DeathStore* target, bool hasPercentage) {
+	this->m_target = target;
+	this->m_elementWidth = 4 + 4 + (hasPercentage ? 2 : 0);
+	this->m_start = target->size();
+}
+
+void BinListDecoder::setExpectedSize(size_t bytes) {
+	this->m_expected = bytes;
+	if (this->m_packed && bytes > 1) this->m_packed->setExpectedSize(bytes - 1);
+	if (bytes > 1)
+		this->m_target->reserve(this->m_start + (bytes - 1) / this->m_elementWidth);
+}
+
+bool BinListDecoder::feed(ByteSpan chunk) {
+	if (this->m_state == State::Failed) return false;
+	this->m_consumed += chunk.size();
+	if (chunk.empty()) return true;
+
+	if (this->m_state == State::Version) {
+		this->m_version = chunk[0];
+		chunk = chunk.subspan(1);
+		if (this->m_version == packedListVersion) {
+			this->m_packed.emplace(this->m_target);
+			if (this->m_expected) this->m_packed->setExpectedSize(this->m_expected - 1);
+			this->m_elementWidth = 0;
+		}
+		else if (this->m_version != 1) {
+			this->m_state = State::Failed;
+			return false;
+		}
+		this->m_state = State::Records;
+	}
+	if (this->m_packed) return this->feedPacked(chunk);
+
+	auto const width = this->m_elementWidth;
+
+	// Complete the record split by the previous chunk boundary first
+	if (this->m_carried) {
+		size_t take = std::min(width - this->m_carried, chunk.size());
+		std::memcpy(this->m_carry + this->m_carried, chunk.data(), take);
+		this->m_carried += take;
+		chunk = chunk.subspan(take);
+		if (this->m_carried < width) return true;
+
+		decodeListRecords(this->m_carry, 1, width, this->m_target->extend(1));
+		this->m_carried = 0;
+	}
+
+	size_t whole = chunk.size() / width;
+	decodeListRecords(chunk.data(), whole, width, this->m_target->extend(whole));
+
+	this->m_carried = chunk.size() - whole * width;
+	std::memcpy(this->m_carry, chunk.data() + whole * width, this->m_carried);
+	return true;
+}
+
+bool BinListDecoder::feedPacked(ByteSpan chunk) {
+	auto& pending = this->m_pending;
+	if (pending.empty()) {
+		size_t used = this->m_packed->read(chunk);
+		pending.assign(chunk.begin() + used, chunk.end());
+	}
+	else {
+		pending.insert(pending.end(), chunk.begin(), chunk.end());
+		size_t used = this->m_packed->read(ByteSpan(pending));
+		pending.erase(pending.begin(), pending.begin() + used);
+	}
+
+	if (this->m_packed->getState() == PackedListReader::State::Failed) {
+		this->m_state = State::Failed;
+		return false;
+	}
+	return true;
+}
+
+ParseResult BinListDecoder::finish() {
+	ParseResult result;
+	result.elementWidth = this->m_elementWidth;
+	result.version = this->m_version;
+	result.count = this->getDecoded();
+	result.excess = this->m_carried;
+
+	if (this->m_packed) {
+		result.excess = this->m_pending.size();
+		if (this->m_packed->getState() != PackedListReader::State::Done ||
+			result.excess)
+			result.status = ParseStatus::Malformed;
+	}
+	else if (this->m_consumed <= this->m_elementWidth)
+		result.status = ParseStatus::TooShort;
+	else if (this->m_state == State::Failed)
+		result.status = ParseStatus::UnknownVersion;
+	else if (this->m_carried)
+		result.status = ParseStatus::Misaligned;
+
+	// Incomplete or unusable responses must not leave partial data behind
+	if (result.status != ParseStatus::Ok)
+		this->m_target->truncate(this->m_start);
+	return result;
+}
+
+size_t BinListDecoder::getDecoded() const {
+	return this->m_target->size() - this->m_start;
+}
+
+float BinListDecoder::getProgress() const {
+	if (!this->m_expected) return -1;
+	return std::min(1.0f,
+		static_cast<float>(this->m_consumed) / this->m_expected);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <vector>
+#include "model.hpp"
+#include "analysisStore.hpp"
+#include "deathStore.hpp"
+#include "packedList.hpp"
+
+namespace dm {
+
+	// Outcome of decoding a binary /list or /analysis response
+	enum class ParseStatus {
+		Ok,
+		// Body does not even hold a single record, nothing was decoded
+		TooShort,
+		// Versioning byte is not understood by this client
+		UnknownVersion,
+		// Body length is not a multiple of the record width
+		Misaligned,
+		// Packed (version 2) body is cut off or inconsistent
+		Malformed
+	};
+
+	struct ParseResult {
+		ParseStatus status = ParseStatus::Ok;
+		uint8_t version = 0;
+		size_t elementWidth = 0;
+		size_t count = 0;
+		// Trailing bytes that do not form a whole record
+		size_t excess = 0;
+		// Records whose practice byte was neither 0 nor 1
+		size_t invalidPractice = 0;
+	};
+
+	// Appends to target without sorting it
+	ParseResult parseBinDeathList(ByteSpan body,
+		DeathStore* target, bool hasPercentage);
+	ParseResult parseBinDeathList(ByteSpan body, AnalysisStore* target);
+
+	// Incremental decoder for binary /list responses of either version.
+	// The body can be fed in chunks of any size as it arrives; whole records
+	// (or blocks of version 2) are appended to the target right away, the
+	// part split across a chunk boundary is carried over to the next chunk.
+	class BinListDecoder {
+	public:
+		enum class State {
+			// Waiting for the versioning byte
+			Version,
+			Records,
+			Failed
+		};
+
+		BinListDecoder(DeathStore* target, bool hasPercentage);
+
+		// Reserves space and enables getProgress, e.g. from Content-Length
+		void setExpectedSize(size_t bytes);
+		// Returns false once the response turned out to be unusable
+		bool feed(ByteSpan chunk);
+		// Call once the body is complete. Removes everything this decoder
+		// appended again if the response was not valid as a whole.
+		ParseResult finish();
+
+		State getState() const { return this->m_state; }
+		size_t getConsumed() const { return this->m_consumed; }
+		size_t getDecoded() const;
+		// Fraction of the expected body consumed so far, -1 if unknown
+		float getProgress() const;
+
+	private:
+		DeathStore* m_target;
+		size_t m_elementWidth;
+		// Size of target before decoding started
+		size_t m_start;
+		State m_state = State::Version;
+		uint8_t m_version = 0;
+		size_t m_consumed = 0;
+		size_t m_expected = 0;
+		uint8_t m_carry[10] = {};
+		size_t m_carried = 0;
+		std::optional<PackedListReader> m_packed;
+		// Carry of version 2, which has no fixed record width
+		std::vector<uint8_t> m_pending;
+
+		bool feedPacked(ByteSpan chunk);
+	};
+
+	std::string uint8ToHexString(uint8_t const* v, size_t s);
+
+}
@@ -0,0 +1,310 @@
+#include <bit>
+#include <cstring>
+#include "bulkDecode.hpp"
+#include "simd.hpp"
+
+using namespace dm;
+
+// All records are little endian, as are all platforms the mod runs on
+
+static void decodeListScalar(uint8_t const* records, size_t count,
+	size_t elementWidth, DeathStore::Columns out) {
+
+	for (size_t i = 0; i < count; i++, records += elementWidth) {
+		std::memcpy(out.x + i, records, 4);
+		std::memcpy(out.y + i, records + 4, 4);
+		if (elementWidth < 10) continue;
+		uint16_t perc;
+		std::memcpy(&perc, records + 8, 2);
+		out.percentage[i] = perc;
+	}
+}
+
+static void decodeAnalysisScalar(uint8_t const* records, size_t count,
+	AnalysisStore::Columns out, uint8_t* idents, size_t* invalidPractice) {
+
+	for (size_t i = 0; i < count; i++, records += analysisElementWidth) {
+		std::memcpy(idents + i * AnalysisStore::identWidth, records,
+			AnalysisStore::identWidth);
+		out.levelVersion[i] = records[20];
+		out.practice[i] = records[21];
+		if (records[21] > 1) (*invalidPractice)++;
+		std::memcpy(out.x + i, records + 22, 4);
+		std::memcpy(out.y + i, records + 26, 4);
+		uint16_t perc;
+		std::memcpy(&perc, records + 30, 2);
+		out.percentage[i] = perc;
+	}
+}
+
+#ifdef DM_X86
+
+/*
+*  Vector kernels
+*  --------------
+*  Load one record per 128 bit register with its fields at 4 byte offsets,
+*  then transpose 4x4 so each register holds one field of 4 records.
+*  The AVX2 variants put record k into the low and record k+4 into the high
+*  lane, so the in-lane transpose directly yields 8 consecutive records.
+*  They return how many records they decoded, the caller finishes the rest
+*  with the scalar kernel.
+*/
+
+DM_TARGET_SSE2 static size_t decodeListSSE2(uint8_t const* records,
+	size_t count, size_t elementWidth, DeathStore::Columns out) {
+
+	size_t i = 0;
+	if (elementWidth == 8) {
+		for (; i + 4 <= count; i += 4) {
+			auto const* rec = reinterpret_cast<float const*>(records + i * 8);
+			__m128 a = _mm_loadu_ps(rec);
+			__m128 b = _mm_loadu_ps(rec + 4);
+			_mm_storeu_ps(out.x + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(out.y + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+		return i;
+	}
+
+	__m128i const percMask = _mm_set1_epi32(0xffff);
+	// Each load reads 6 bytes past its record, so stop one record early
+	for (; i + 5 <= count; i += 4) {
+		uint8_t const* rec = records + i * 10;
+		__m128 r0 = _mm_loadu_ps(reinterpret_cast<float const*>(rec));
+		__m128 r1 = _mm_loadu_ps(reinterpret_cast<float const*>(rec + 10));
+		__m128 r2 = _mm_loadu_ps(reinterpret_cast<float const*>(rec + 20));
+		__m128 r3 = _mm_loadu_ps(reinterpret_cast<float const*>(rec + 30));
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		_mm_storeu_ps(out.x + i, r0);
+		_mm_storeu_ps(out.y + i, r1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out.percentage + i),
+			_mm_and_si128(_mm_castps_si128(r2), percMask));
+	}
+	return i;
+}
+
+// Loads 16 bytes at low into the low and at high into the high lane
+DM_TARGET_AVX2 static inline __m256i loadLanes(uint8_t const* low,
+	uint8_t const* high) {
+	return _mm256_inserti128_si256(
+		_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const*>(low))),
+		_mm_loadu_si128(reinterpret_cast<__m128i const*>(high)), 1);
+}
+
+// In-lane 4x4 transpose, only the first three rows are needed
+DM_TARGET_AVX2 static inline void transposeLanes(__m256 r0, __m256 r1,
+	__m256 r2, __m256 r3, __m256* x, __m256* y, __m256* z) {
+	__m256d t0 = _mm256_castps_pd(_mm256_unpacklo_ps(r0, r1));
+	__m256d t1 = _mm256_castps_pd(_mm256_unpackhi_ps(r0, r1));
+	__m256d t2 = _mm256_castps_pd(_mm256_unpacklo_ps(r2, r3));
+	__m256d t3 = _mm256_castps_pd(_mm256_unpackhi_ps(r2, r3));
+	*x = _mm256_castpd_ps(_mm256_unpacklo_pd(t0, t2));
+	*y = _mm256_castpd_ps(_mm256_unpackhi_pd(t0, t2));
+	*z = _mm256_castpd_ps(_mm256_unpacklo_pd(t1, t3));
+}
+
+DM_TARGET_AVX2 static size_t decodeListAVX2(uint8_t const* records,
+	size_t count, size_t elementWidth, DeathStore::Columns out) {
+
+	size_t i = 0;
+	if (elementWidth == 8) {
+		for (; i + 8 <= count; i += 8) {
+			auto const* rec = reinterpret_cast<float const*>(records + i * 8);
+			__m256 a = _mm256_loadu_ps(rec);
+			__m256 b = _mm256_loadu_ps(rec + 8);
+			// x0 x1 x4 x5 | x2 x3 x6 x7, restore order by swapping the middle
+			__m256 x = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+			__m256 y = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+			_mm256_storeu_ps(out.x + i, _mm256_castpd_ps(_mm256_permute4x64_pd(
+				_mm256_castps_pd(x), _MM_SHUFFLE(3, 1, 2, 0))));
+			_mm256_storeu_ps(out.y + i, _mm256_castpd_ps(_mm256_permute4x64_pd(
+				_mm256_castps_pd(y), _MM_SHUFFLE(3, 1, 2, 0))));
+		}
+		return i;
+	}
+
+	__m256i const percMask = _mm256_set1_epi32(0xffff);
+	// Each load reads 6 bytes past its record, so stop one record early
+	for (; i + 9 <= count; i += 8) {
+		uint8_t const* rec = records + i * 10;
+		__m256 r0 = _mm256_castsi256_ps(loadLanes(rec, rec + 40));
+		__m256 r1 = _mm256_castsi256_ps(loadLanes(rec + 10, rec + 50));
+		__m256 r2 = _mm256_castsi256_ps(loadLanes(rec + 20, rec + 60));
+		__m256 r3 = _mm256_castsi256_ps(loadLanes(rec + 30, rec + 70));
+		__m256 x, y, perc;
+		transposeLanes(r0, r1, r2, r3, &x, &y, &perc);
+
+		_mm256_storeu_ps(out.x + i, x);
+		_mm256_storeu_ps(out.y + i, y);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out.percentage + i),
+			_mm256_and_si256(_mm256_castps_si256(perc), percMask));
+	}
+	return i;
+}
+
+DM_TARGET_AVX2 static size_t decodeAnalysisAVX2(uint8_t const* records,
+	size_t count, AnalysisStore::Columns out, uint8_t* idents,
+	size_t* invalidPractice) {
+
+	__m256i const byteMask = _mm256_set1_epi32(0xff);
+	__m256i const one = _mm256_set1_epi32(1);
+	__m256i const percMask = _mm256_set1_epi32(0xffff);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		uint8_t const* rec = records + i * analysisElementWidth;
+		for (size_t k = 0; k < 8; k++) {
+			std::memcpy(idents + (i + k) * AnalysisStore::identWidth,
+				rec + k * analysisElementWidth, AnalysisStore::identWidth);
+		}
+
+		// Last 16 bytes of each record, records k and k + 4 per register:
+		// ident[16..19] | version, practice, x[0..1] | x[2..3], y[0..1] | y[2..3], perc
+		__m256i v0 = loadLanes(rec + 16, rec + 144);
+		__m256i v1 = loadLanes(rec + 48, rec + 176);
+		__m256i v2 = loadLanes(rec + 80, rec + 208);
+		__m256i v3 = loadLanes(rec + 112, rec + 240);
+
+		__m256i meta = _mm256_unpackhi_epi64(
+			_mm256_unpacklo_epi32(v0, v1), _mm256_unpacklo_epi32(v2, v3));
+		__m256i version = _mm256_and_si256(meta, byteMask);
+		__m256i practice = _mm256_and_si256(_mm256_srli_epi32(meta, 8), byteMask);
+		*invalidPractice += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(
+			_mm256_castsi256_ps(_mm256_cmpgt_epi32(practice, one)))));
+
+		// Per lane: 4 version bytes, 4 practice bytes, zeros
+		__m256i packed = _mm256_packus_epi16(
+			_mm256_packs_epi32(version, practice), _mm256_setzero_si256());
+		__m128i low = _mm256_castsi256_si128(packed);
+		__m128i high = _mm256_extracti128_si256(packed, 1);
+		int32_t bytes[4] = {
+			_mm_cvtsi128_si32(low), _mm_cvtsi128_si32(high),
+			_mm_cvtsi128_si32(_mm_srli_si128(low, 4)),
+			_mm_cvtsi128_si32(_mm_srli_si128(high, 4))
+		};
+		std::memcpy(out.levelVersion + i, bytes, 8);
+		std::memcpy(out.practice + i, bytes + 2, 8);
+
+		__m256 x, y, perc;
+		transposeLanes(
+			_mm256_castsi256_ps(_mm256_srli_si256(v0, 6)),
+			_mm256_castsi256_ps(_mm256_srli_si256(v1, 6)),
+			_mm256_castsi256_ps(_mm256_srli_si256(v2, 6)),
+			_mm256_castsi256_ps(_mm256_srli_si256(v3, 6)),
+			&x, &y, &perc);
+
+		_mm256_storeu_ps(out.x + i, x);
+		_mm256_storeu_ps(out.y + i, y);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out.percentage + i),
+			_mm256_and_si256(_mm256_castps_si256(perc), percMask));
+	}
+	return i;
+}
+
+static void cpuid(int info[4], int leaf) {
+#if defined(_MSC_VER) && !defined(__clang__)
+	__cpuidex(info, leaf, 0);
+#else
+	unsigned a = 0, b = 0, c = 0, d = 0;
+	__cpuid_count(leaf, 0, a, b, c, d);
+	info[0] = a;
+	info[1] = b;
+	info[2] = c;
+	info[3] = d;
+#endif
+}
+
+static uint64_t xgetbv() {
+#if defined(_MSC_VER) && !defined(__clang__)
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+#endif
+
+DecodeKernel dm::getSupportedKernel() {
+#ifdef DM_X86
+	static DecodeKernel const supported = [] {
+		int info[4];
+		cpuid(info, 0);
+		int const maxLeaf = info[0];
+
+		cpuid(info, 1);
+		if (!(info[3] & (1 << 26))) return DecodeKernel::Scalar;
+		bool const osxsave = info[2] & (1 << 27);
+		bool const avx = info[2] & (1 << 28);
+		// The OS also has to preserve the upper halves of the YMM registers
+		if (!osxsave || !avx || (xgetbv() & 6) != 6 || maxLeaf < 7)
+			return DecodeKernel::SSE2;
+
+		cpuid(info, 7);
+		return info[1] & (1 << 5) ? DecodeKernel::AVX2 : DecodeKernel::SSE2;
+	}();
+	return supported;
+#else
+	return DecodeKernel::Scalar;
+#endif
+}
+
+static DecodeKernel& activeKernel() {
+	static DecodeKernel kernel = getSupportedKernel();
+	return kernel;
+}
+
+DecodeKernel dm::getDecodeKernel() {
+	return activeKernel();
+}
+
+void dm::setDecodeKernel(DecodeKernel kernel) {
+	if (kernel > getSupportedKernel()) kernel = getSupportedKernel();
+	activeKernel() = kernel;
+}
+
+void dm::decodeListRecords(uint8_t const* records, size_t count,
+	size_t elementWidth, DeathStore::Columns out) {
+
+	size_t done = 0;
+#ifdef DM_X86
+	switch (activeKernel()) {
+		case DecodeKernel::AVX2:
+			done = decodeListAVX2(records, count, elementWidth, out);
+			break;
+		case DecodeKernel::SSE2:
+			done = decodeListSSE2(records, count, elementWidth, out);
+			break;
+		default: break;
+	}
+#endif
+
+	decodeListScalar(records + done * elementWidth, count - done, elementWidth,
+		{ out.x + done, out.y + done, out.percentage + done });
+}
+
+size_t dm::decodeAnalysisRecords(uint8_t const* records, size_t count,
+	AnalysisStore::Columns out, uint8_t* idents) {
+
+	size_t invalidPractice = 0;
+	size_t done = 0;
+#ifdef DM_X86
+	// Copying the idents takes most of the time, which a 4 record SSE2
+	// kernel did no faster than the scalar one
+	if (activeKernel() == DecodeKernel::AVX2) {
+		done = decodeAnalysisAVX2(records, count, out, idents,
+			&invalidPractice);
+	}
+#endif
+
+	decodeAnalysisScalar(records + done * analysisElementWidth, count - done, {
+		out.player + done,
+		out.x + done,
+		out.y + done,
+		out.percentage + done,
+		out.levelVersion + done,
+		out.practice + done
+	}, idents + done * AnalysisStore::identWidth, &invalidPractice);
+	return invalidPractice;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "analysisStore.hpp"
+#include "deathStore.hpp"
+
+// Bulk decoders that deinterleave fixed-width binary records straight into
+// columns. The implementation is picked at runtime from what the CPU
+// supports, all of them produce identical output.
+
+namespace dm {
+
+	enum class DecodeKernel {
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	// Best kernel this machine supports
+	DecodeKernel getSupportedKernel();
+	DecodeKernel getDecodeKernel();
+	// Forces a kernel, e.g. for benchmarking. Kernels the CPU does not
+	// support fall back to the best supported one. Also applies to the
+	// columns of version 2 lists, which only have a scalar and AVX2 kernel.
+	void setDecodeKernel(DecodeKernel kernel);
+
+	// Decodes count /list records of elementWidth 8 (x, y) or 10 (x, y,
+	// percentage). Percentages of 8 byte records are left untouched.
+	void decodeListRecords(uint8_t const* records, size_t count,
+		size_t elementWidth, DeathStore::Columns out);
+
+	size_t const analysisElementWidth = 20 + 1 + 1 + 4 + 4 + 2;
+	// Version 2 /analysis records: player, levelversion, practice,
+	// percentage, x, y
+	uint8_t const analysisDictionaryVersion = 2;
+	size_t const analysisDictionaryElementWidth = 4 + 1 + 1 + 2 + 4 + 4;
+
+	// Decodes count version 1 /analysis records, leaving the player column
+	// untouched and writing the identWidth byte idents to idents instead.
+	// Returns how many of them had a practice byte other than 0 or 1.
+	size_t decodeAnalysisRecords(uint8_t const* records, size_t count,
+		AnalysisStore::Columns out, uint8_t* idents);
+
+}
@@ -0,0 +1,232 @@
+#include <iterator>
+#include "chunkedStore.hpp"
+#include "search.hpp"
+
+using namespace dm;
+
+// Deaths a chunk is filled with by merge, leaving room for inserts
+static constexpr size_t mergeFill = ChunkedDeathStore::chunkCapacity * 3 / 4;
+
+void ChunkedDeathStore::clear() {
+	this->m_chunks.clear();
+	this->m_starts.clear();
+	this->m_lastX.clear();
+	this->m_size = 0;
+}
+
+std::pair<size_t, size_t> ChunkedDeathStore::locate(size_t index) const {
+	size_t const chunk = std::upper_bound(this->m_starts.begin(),
+		this->m_starts.end(), index) - this->m_starts.begin() - 1;
+	return { chunk, index - this->m_starts[chunk] };
+}
+
+void ChunkedDeathStore::updateChunkIndex(size_t from) {
+	this->m_starts.resize(this->m_chunks.size());
+	this->m_lastX.resize(this->m_chunks.size());
+	for (size_t i = from; i < this->m_chunks.size(); i++) {
+		this->m_starts[i] = i == 0 ? 0 : this->m_starts[i - 1] + this->m_chunks[i - 1].size();
+		this->m_lastX[i] = this->m_chunks[i].x.back();
+	}
+}
+
+float ChunkedDeathStore::x(size_t index) const {
+	auto [chunk, offset] = this->locate(index);
+	return this->m_chunks[chunk].x[offset];
+}
+
+Vec2 ChunkedDeathStore::pos(size_t index) const {
+	auto [chunk, offset] = this->locate(index);
+	auto const& deaths = this->m_chunks[chunk];
+	return { deaths.x[offset], deaths.y[offset] };
+}
+
+int ChunkedDeathStore::percentage(size_t index) const {
+	auto [chunk, offset] = this->locate(index);
+	return this->m_chunks[chunk].percentage[offset];
+}
+
+GhostPose const* ChunkedDeathStore::ghost(size_t index) const {
+	auto [chunk, offset] = this->locate(index);
+	auto const& deaths = this->m_chunks[chunk];
+	if (deaths.ghost.empty() || !deaths.ghost[offset]) return nullptr;
+	return &*deaths.ghost[offset];
+}
+
+DeathEntry ChunkedDeathStore::entry(size_t index) const {
+	DeathEntry entry;
+	entry.pos = this->pos(index);
+	entry.percentage = this->percentage(index);
+	if (auto pose = this->ghost(index)) entry.ghost = *pose;
+	return entry;
+}
+
+size_t ChunkedDeathStore::lowerBound(float x) const {
+	// First chunk ending at or after x holds the result, if any does
+	size_t const chunk = lowerBoundBranchless(this->m_lastX, x);
+	if (chunk == this->m_chunks.size()) return this->m_size;
+	return this->m_starts[chunk] + lowerBoundBranchless(this->m_chunks[chunk].x, x);
+}
+
+size_t ChunkedDeathStore::upperBound(float x) const {
+	size_t const chunk = upperBoundBranchless(this->m_lastX, x);
+	if (chunk == this->m_chunks.size()) return this->m_size;
+	return this->m_starts[chunk] + upperBoundBranchless(this->m_chunks[chunk].x, x);
+}
+
+size_t ChunkedDeathStore::indexOf(Handle handle) const {
+	if (!handle) return npos;
+
+	// The death is among those with the same x, usually the only one
+	size_t index = this->lowerBound(handle.x);
+	if (index == this->m_size) return npos;
+	auto [chunk, offset] = this->locate(index);
+	for (; chunk < this->m_chunks.size(); chunk++, offset = 0) {
+		auto const& deaths = this->m_chunks[chunk];
+		for (; offset < deaths.size(); offset++, index++) {
+			if (deaths.x[offset] != handle.x) return npos;
+			if (deaths.id[offset] == handle.id) return index;
+		}
+	}
+	return npos;
+}
+
+bool ChunkedDeathStore::refersTo(Handle handle, size_t index) const {
+	if (!handle) return false;
+	auto [chunk, offset] = this->locate(index);
+	return this->m_chunks[chunk].id[offset] == handle.id;
+}
+
+template <typename T>
+static void moveTail(std::vector<T>& from, std::vector<T>& to, size_t at) {
+	to.assign(std::make_move_iterator(from.begin() + at),
+		std::make_move_iterator(from.end()));
+	from.resize(at);
+}
+
+void ChunkedDeathStore::split(size_t chunk) {
+	this->m_chunks.emplace(this->m_chunks.begin() + chunk + 1);
+	auto& front = this->m_chunks[chunk];
+	auto& back = this->m_chunks[chunk + 1];
+	size_t const half = front.size() / 2;
+
+	back.x.reserve(chunkCapacity + 1);
+	back.y.reserve(chunkCapacity + 1);
+	back.percentage.reserve(chunkCapacity + 1);
+	back.id.reserve(chunkCapacity + 1);
+	moveTail(front.x, back.x, half);
+	moveTail(front.y, back.y, half);
+	moveTail(front.percentage, back.percentage, half);
+	moveTail(front.id, back.id, half);
+	if (!front.ghost.empty()) moveTail(front.ghost, back.ghost, half);
+}
+
+ChunkedDeathStore::Handle ChunkedDeathStore::insert(Vec2 pos, int percentage,
+	std::optional<GhostPose> const& ghost) {
+
+	// First chunk ending after x, or the last one to append to
+	size_t chunk = upperBoundBranchless(this->m_lastX, pos.x);
+	if (chunk == this->m_chunks.size()) {
+		if (this->m_chunks.empty()) this->m_chunks.emplace_back();
+		else chunk--;
+	}
+
+	auto& deaths = this->m_chunks[chunk];
+	size_t const offset = upperBoundBranchless(deaths.x, pos.x);
+	Handle const handle{ pos.x, this->m_nextId++ };
+
+	deaths.x.insert(deaths.x.begin() + offset, pos.x);
+	deaths.y.insert(deaths.y.begin() + offset, pos.y);
+	deaths.percentage.insert(deaths.percentage.begin() + offset, percentage);
+	deaths.id.insert(deaths.id.begin() + offset, handle.id);
+	if (ghost && deaths.ghost.empty()) deaths.ghost.resize(deaths.size() - 1);
+	if (ghost || !deaths.ghost.empty())
+		deaths.ghost.insert(deaths.ghost.begin() + offset, ghost);
+	this->m_size++;
+
+	if (deaths.size() > chunkCapacity) this->split(chunk);
+	this->updateChunkIndex(chunk);
+	return handle;
+
+}
+
+void ChunkedDeathStore::merge(DeathStore const& other) {
+	if (other.empty()) return;
+
+	// Only chunks overlapping the new deaths are rewritten, the ones ending
+	// before the first or starting after the last stay as they are
+	float const first = other.x(0);
+	float const last = other.x(other.size() - 1);
+	size_t const kept = upperBoundBranchless(this->m_lastX, first);
+	size_t end = upperBoundBranchless(this->m_lastX, last);
+	if (end < this->m_chunks.size() && this->m_chunks[end].x.front() <= last) end++;
+
+	std::vector<Chunk> merged;
+	auto push = [&merged](float x, float y, int percentage, uint32_t id,
+		std::optional<GhostPose> const& ghost) {
+		if (merged.empty() || merged.back().size() == mergeFill) {
+			auto& deaths = merged.emplace_back();
+			deaths.x.reserve(chunkCapacity + 1);
+			deaths.y.reserve(chunkCapacity + 1);
+			deaths.percentage.reserve(chunkCapacity + 1);
+			deaths.id.reserve(chunkCapacity + 1);
+		}
+		auto& deaths = merged.back();
+		deaths.x.push_back(x);
+		deaths.y.push_back(y);
+		deaths.percentage.push_back(percentage);
+		deaths.id.push_back(id);
+		if (ghost && deaths.ghost.empty()) deaths.ghost.resize(deaths.size() - 1);
+		if (ghost || !deaths.ghost.empty()) deaths.ghost.push_back(ghost);
+	};
+
+	size_t theirs = 0;
+	auto pushTheirs = [&](size_t index) {
+		auto pose = other.ghost(index);
+		push(other.x(index), other.y(index), other.percentage(index), 0,
+			pose ? std::optional(*pose) : std::nullopt);
+	};
+	for (size_t chunk = kept; chunk < end; chunk++) {
+		auto& deaths = this->m_chunks[chunk];
+		for (size_t i = 0; i < deaths.size(); i++) {
+			// Ours go first among equal x
+			for (; theirs < other.size() && other.x(theirs) < deaths.x[i]; theirs++)
+				pushTheirs(theirs);
+			push(deaths.x[i], deaths.y[i], deaths.percentage[i], deaths.id[i],
+				deaths.ghost.empty() ? std::nullopt : std::move(deaths.ghost[i]));
+		}
+	}
+	for (; theirs < other.size(); theirs++) pushTheirs(theirs);
+
+	this->m_chunks.erase(this->m_chunks.begin() + kept, this->m_chunks.begin() + end);
+	this->m_chunks.insert(this->m_chunks.begin() + kept,
+		std::make_move_iterator(merged.begin()), std::make_move_iterator(merged.end()));
+	this->m_size += other.size();
+	this->updateChunkIndex(kept);
+}
+
+void ChunkedDeathStore::erase(size_t begin, size_t end) {
+	if (begin >= end) return;
+
+	auto [chunk, offset] = this->locate(begin);
+	size_t const from = chunk;
+	size_t remaining = end - begin;
+	while (remaining > 0) {
+		auto& deaths = this->m_chunks[chunk];
+		size_t const count = std::min(deaths.size() - offset, remaining);
+		auto eraseRange = [offset, count](auto& column) {
+			column.erase(column.begin() + offset, column.begin() + offset + count);
+		};
+		eraseRange(deaths.x);
+		eraseRange(deaths.y);
+		eraseRange(deaths.percentage);
+		eraseRange(deaths.id);
+		if (!deaths.ghost.empty()) eraseRange(deaths.ghost);
+		remaining -= count;
+
+		if (deaths.x.empty()) this->m_chunks.erase(this->m_chunks.begin() + chunk);
+		else chunk++;
+		offset = 0;
+	}
+	this->m_size -= end - begin;
+	this->updateChunkIndex(from);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+#include "model.hpp"
+#include "deathStore.hpp"
+
+namespace dm {
+
+	// Deaths kept sorted by x in chunks of at most chunkCapacity deaths, each
+	// holding its columns back to back like DeathStore. Inserting only moves
+	// the deaths of one chunk, however many deaths there are in total.
+	// Deaths are addressed by index like in DeathStore, which changes as
+	// deaths are added before it, or by a Handle, which does not.
+	class ChunkedDeathStore {
+	public:
+		static constexpr size_t npos = DeathStore::npos;
+		static constexpr size_t chunkCapacity = 2048;
+
+		// Refers to a death added by insert until it is erased. A default
+		// constructed handle refers to none.
+		struct Handle {
+			float x = 0;
+			uint32_t id = 0;
+
+			explicit operator bool() const { return this->id != 0; }
+			bool operator==(Handle const&) const = default;
+		};
+
+		// Columns of a range of deaths within a single chunk
+		struct Span {
+			std::span<float const> x;
+			std::span<float const> y;
+			std::span<int const> percentage;
+		};
+
+		size_t size() const { return this->m_size; }
+		bool empty() const { return this->m_size == 0; }
+		void clear();
+
+		float x(size_t index) const;
+		Vec2 pos(size_t index) const;
+		int percentage(size_t index) const;
+		// nullptr if the death was not recorded as a ghost
+		GhostPose const* ghost(size_t index) const;
+		DeathEntry entry(size_t index) const;
+
+		// Index of the first death with x >= or > x, size() if there is none
+		size_t lowerBound(float x) const;
+		size_t upperBound(float x) const;
+		// Index of the death handle refers to, npos if it was erased
+		size_t indexOf(Handle handle) const;
+		bool refersTo(Handle handle, size_t index) const;
+
+		// Calls fn(Span) for the deaths in [begin, end), a chunk at a time
+		template <typename F>
+		void forEachSpan(size_t begin, size_t end, F&& fn) const {
+			if (begin >= end) return;
+			auto [chunk, offset] = this->locate(begin);
+			for (; begin < end; chunk++, offset = 0) {
+				auto const& deaths = this->m_chunks[chunk];
+				size_t const count = std::min(deaths.size() - offset, end - begin);
+				fn(Span{
+					std::span(deaths.x).subspan(offset, count),
+					std::span(deaths.y).subspan(offset, count),
+					std::span(deaths.percentage).subspan(offset, count)
+				});
+				begin += count;
+			}
+		}
+
+		// Inserts after all deaths with the same x
+		Handle insert(Vec2 pos, int percentage,
+			std::optional<GhostPose> const& ghost = std::nullopt);
+		// Merges the x-sorted deaths of other in a single linear pass over the
+		// chunks they overlap. Deaths already stored go first among equal x.
+		void merge(DeathStore const& other);
+		// Drops the deaths with indices in [begin, end)
+		void erase(size_t begin, size_t end);
+
+	private:
+		struct Chunk {
+			std::vector<float> x;
+			std::vector<float> y;
+			std::vector<int> percentage;
+			// Handle ids, 0 for deaths not added by insert
+			std::vector<uint32_t> id;
+			// Empty until the chunk holds a ghost, like in DeathStore
+			std::vector<std::optional<GhostPose>> ghost;
+
+			size_t size() const { return this->x.size(); }
+		};
+
+		// Never holds an empty chunk
+		std::vector<Chunk> m_chunks;
+		// Index of the first death of each chunk
+		std::vector<size_t> m_starts;
+		// Largest x of each chunk, searched to find the chunk holding an x
+		std::vector<float> m_lastX;
+		size_t m_size = 0;
+		uint32_t m_nextId = 1;
+
+		// Chunk holding the death at index and its position in it
+		std::pair<size_t, size_t> locate(size_t index) const;
+		// Brings m_starts and m_lastX up to date from chunk from onwards
+		void updateChunkIndex(size_t from);
+		void split(size_t chunk);
+	};
+
+}
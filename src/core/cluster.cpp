@@ -1,69 +1,55 @@
+#include <algorithm>
+#include <cmath>
 #include "cluster.hpp"
 
 using namespace dm;
 
-DeathLocationStack::DeathLocationStack(vector<DeathLocation*> deaths) {
-	this->deaths = deaths;
-	this->recalculate();
+DeathLocationStack::DeathLocationStack(std::vector<size_t> deaths,
+	std::vector<Vec2> const& positions) {
+	this->deaths = std::move(deaths);
+	this->recalculate(positions);
 }
 
 DeathLocationStack::DeathLocationStack() {
-	this->deaths = vector<DeathLocation*>();
-	this->recalculate();
+	this->deaths = std::vector<size_t>();
+	this->circle = Circle::INVALID;
 }
 
 // Time complexity O(n)
 // Auxiliary space complexity O(1)
-CCPoint averagePos(vector<DeathLocation*>::iterator const begin,
-	vector<DeathLocation*>::iterator const end) {
-	double avgX = 0;
-	double avgY = 0;
-
-	for (auto death = begin; death < end; death++) {
-		avgX += (*death)->pos.x;
-		avgY += (*death)->pos.y;
-	}
-
-	avgX /= end - begin;
-	avgY /= end - begin;
-
-	return CCPoint(avgX, avgY);
-}
-
-// Time complexity O(n)
-// Auxiliary space complexity O(1)
-void DeathLocationStack::recalculate() {
-	vector<CCPoint> points;
+void DeathLocationStack::recalculate(std::vector<Vec2> const& positions) {
+	std::vector<Vec2> points;
+	points.reserve(this->deaths.size());
 	for (auto i = this->deaths.begin(); i < this->deaths.end(); i++)
-		points.push_back((*i)->pos);
+		points.push_back(positions[*i]);
 	this->circle = makeSmallestEnclosingCircle(points);
 	this->density = this->circle.r ? static_cast<float>(this->deaths.size()) / (this->circle.r * this->circle.r) : -1;
 }
 
 // Time complexity O(n)
 // Auxiliary space complexity O(1)
-DeathLocationStack mergeStacks(vector<DeathLocationStack>* stacks,
-	vector<DeathLocationStack>::iterator a,
-	vector<DeathLocationStack>::iterator b) {
+DeathLocationStack mergeStacks(std::vector<DeathLocationStack>::iterator a,
+	std::vector<DeathLocationStack>::iterator b,
+	std::vector<Vec2> const& positions) {
 	// Merge into new Stack
 	auto merged = DeathLocationStack();
 	merged.deaths.reserve(a->deaths.size() + b->deaths.size());
 	merged.deaths.insert(merged.deaths.end(), a->deaths.begin(), a->deaths.end());
 	merged.deaths.insert(merged.deaths.end(), b->deaths.begin(), b->deaths.end());
-	merged.recalculate();
+	merged.recalculate(positions);
 	return merged;
 }
 
 // Time complexity O(n)
 // Auxiliary space complexity O(1)
-int findNearest(vector<DeathLocationStack> const* stacks,
-	vector<DeathLocationStack>::iterator source, float maxDistance) {
+int findNearest(std::vector<DeathLocationStack> const* stacks,
+	std::vector<DeathLocationStack>::iterator source, float maxDistance) {
 	// Assumes death stacks vector is (roughly) sorted by x-coordinate
 
-	CCPoint srcPoint = source->circle.c;
+	Vec2 srcPoint = source->circle.c;
 	float minDistSq = maxDistance;
 	int minimum = -1;
-	
+
 	// Walk right
 	for (auto i = source + 1; i < stacks->end(); i++) {
 		// All points from here will be out of range on x alone, skip
@@ -88,30 +74,25 @@ int findNearest(vector<DeathLocationStack> const* stacks,
 	return minimum;
 }
 
-void dm::identifyClusters(vector<DeathLocation>* deaths,
-	float maxDistance, vector<DeathLocationStack>* stacks) {
+void dm::identifyClusters(std::vector<Vec2> const& positions,
+	float maxDistance, std::vector<DeathLocationStack>* stacks) {
 
 	/*
 	*  Hierarchical Clustering
 	*  -----------------------
 	*  Turn each node into a single-element cluster,
 	*  repeatedly merge all clusters until no more merging can take place
-	*  Assumes deaths vector is sorted by x-coordinate
+	*  Assumes positions vector is sorted by x-coordinate
 	*/
 
-	log::debug("Clustering {} entries with maximum distance {}",
-		deaths->size(), maxDistance);
 	stacks->clear();
-	stacks->reserve(deaths->size());
+	stacks->reserve(positions.size());
 
-	for (auto i = deaths->begin(); i < deaths->end(); i++) {
-		vector<DeathLocation*> vector;
-		i->clustered = false;
-		vector.push_back(&*i);
-		stacks->push_back(DeathLocationStack(vector));
+	for (size_t i = 0; i < positions.size(); i++) {
+		stacks->push_back(DeathLocationStack({ i }, positions));
 	}
 	// At this point, death stacks vector is also sorted by x-coordinate
-	
+
 	int iter = 0;
 	while (true) {
 		bool didMerge = false;
@@ -135,11 +116,11 @@ void dm::identifyClusters(vector<DeathLocation>* deaths,
 				continue;
 			}
 			auto nearest = stacks->begin() + nearestIdx;
-			auto merged = mergeStacks(stacks, i, nearest);
+			auto merged = mergeStacks(i, nearest, positions);
 
 			if (
 				i->circle.r != 0 && nearest->circle.r != 0 &&
-				log2(maxMergeDist) * merged.density < min(i->density, nearest->density) / 4
+				std::log2(maxMergeDist) * merged.density < std::min(i->density, nearest->density) / 4
 			) {
 				i++;
 				continue;
@@ -162,14 +143,7 @@ void dm::identifyClusters(vector<DeathLocation>* deaths,
 		if (!didMerge) break;
 	}
 
-	erase_if(*stacks, [maxDistance](const DeathLocationStack& stack) {
-		for (auto i = stack.deaths.begin(); i < stack.deaths.end(); i++) {
-			(*i)->clustered = true;
-		}
-		if (stack.deaths.size() == 1) return true;
-		// if (stack.diameter == 0) return false;
-		return false;
+	std::erase_if(*stacks, [](const DeathLocationStack& stack) {
+		return stack.deaths.size() == 1;
 	});
-
-	log::debug("Finished clustering into {} stacks.", stacks->size());
-}
\ No newline at end of file
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include "model.hpp"
+#include "lib/smallestCircle.hpp"
+
+namespace dm {
+
+	class DeathLocationStack {
+	public:
+		// Indices into the list of positions the stack was clustered from
+		std::vector<size_t> deaths;
+		Circle circle;
+		float density = 0;
+	
+		DeathLocationStack();
+		DeathLocationStack(std::vector<size_t> deaths,
+			std::vector<Vec2> const& positions);
+
+		void recalculate(std::vector<Vec2> const& positions);
+	};
+
+	void identifyClusters(std::vector<Vec2> const& positions,
+		float maxDistance, std::vector<DeathLocationStack>* stacks);
+
+}
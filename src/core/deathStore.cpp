@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <numeric>
+#include "deathStore.hpp"
+
+using namespace dm;
+
+// Reorders a column so that column[i] = previous column[order[i]]
+template <typename T>
+static void applyOrder(std::vector<T>& column, std::vector<size_t> const& order) {
+	std::vector<T> sorted;
+	sorted.reserve(column.size());
+	for (auto index : order) sorted.push_back(std::move(column[index]));
+	column = std::move(sorted);
+}
+
+void DeathStore::clear() {
+	this->m_x.clear();
+	this->m_y.clear();
+	this->m_percentage.clear();
+	this->m_ghost.clear();
+}
+
+void DeathStore::reserve(size_t count) {
+	this->m_x.reserve(count);
+	this->m_y.reserve(count);
+	this->m_percentage.reserve(count);
+	if (this->hasGhosts()) this->m_ghost.reserve(count);
+}
+
+void DeathStore::truncate(size_t count) {
+	if (count >= this->size()) return;
+	this->m_x.resize(count);
+	this->m_y.resize(count);
+	this->m_percentage.resize(count);
+	if (this->hasGhosts()) this->m_ghost.resize(count);
+}
+
+void DeathStore::erase(size_t begin, size_t end) {
+	if (begin >= end) return;
+	this->m_x.erase(this->m_x.begin() + begin, this->m_x.begin() + end);
+	this->m_y.erase(this->m_y.begin() + begin, this->m_y.begin() + end);
+	this->m_percentage.erase(this->m_percentage.begin() + begin,
+		this->m_percentage.begin() + end);
+	if (this->hasGhosts())
+		this->m_ghost.erase(this->m_ghost.begin() + begin, this->m_ghost.begin() + end);
+}
+
+GhostPose const* DeathStore::ghost(size_t index) const {
+	if (!this->hasGhosts() || !this->m_ghost[index]) return nullptr;
+	return &*this->m_ghost[index];
+}
+
+DeathEntry DeathStore::entry(size_t index) const {
+	DeathEntry entry;
+	entry.pos = this->pos(index);
+	entry.percentage = this->m_percentage[index];
+	if (auto pose = this->ghost(index)) entry.ghost = *pose;
+	return entry;
+}
+
+void DeathStore::push_back(Vec2 pos, int percentage) {
+	this->m_x.push_back(pos.x);
+	this->m_y.push_back(pos.y);
+	this->m_percentage.push_back(percentage);
+	if (this->hasGhosts()) this->m_ghost.emplace_back();
+}
+
+void DeathStore::push_back(DeathEntry const& entry) {
+	this->push_back(entry.pos, entry.percentage);
+	if (entry.ghost) this->setGhost(this->size() - 1, entry.ghost);
+}
+
+DeathStore::Columns DeathStore::extend(size_t count) {
+	size_t const start = this->size();
+	this->m_x.resize(start + count);
+	this->m_y.resize(start + count);
+	this->m_percentage.resize(start + count);
+	if (this->hasGhosts()) this->m_ghost.resize(start + count);
+
+	return {
+		this->m_x.data() + start,
+		this->m_y.data() + start,
+		this->m_percentage.data() + start
+	};
+}
+
+void DeathStore::append(DeathStore const& other) {
+	size_t const start = this->size();
+	this->m_x.insert(this->m_x.end(), other.m_x.begin(), other.m_x.end());
+	this->m_y.insert(this->m_y.end(), other.m_y.begin(), other.m_y.end());
+	this->m_percentage.insert(this->m_percentage.end(),
+		other.m_percentage.begin(), other.m_percentage.end());
+
+	if (this->hasGhosts()) this->m_ghost.resize(this->size());
+	if (other.hasGhosts()) {
+		for (size_t i = 0; i < other.size(); i++) {
+			if (other.m_ghost[i]) this->setGhost(start + i, other.m_ghost[i]);
+		}
+	}
+}
+
+void DeathStore::sortByX() {
+	if (this->isSorted()) return;
+
+	std::vector<size_t> order(this->size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+		return this->m_x[a] < this->m_x[b];
+	});
+
+	applyOrder(this->m_x, order);
+	applyOrder(this->m_y, order);
+	applyOrder(this->m_percentage, order);
+	if (this->hasGhosts()) applyOrder(this->m_ghost, order);
+}
+
+bool DeathStore::isSorted() const {
+	return std::is_sorted(this->m_x.begin(), this->m_x.end());
+}
+
+size_t DeathStore::merge(DeathStore const& other, size_t track) {
+	if (other.empty()) return track;
+
+	size_t const count = this->size();
+	bool const ghosts = this->hasGhosts() || other.hasGhosts();
+	this->m_x.resize(count + other.size());
+	this->m_y.resize(count + other.size());
+	this->m_percentage.resize(count + other.size());
+	if (ghosts) this->m_ghost.resize(count + other.size());
+
+	// Fill from the back, so no death is overwritten before it has moved
+	size_t own = count;
+	size_t theirs = other.size();
+	size_t out = this->size();
+	size_t tracked = npos;
+	while (theirs > 0) {
+		out--;
+		if (own > 0 && this->m_x[own - 1] > other.m_x[theirs - 1]) {
+			own--;
+			if (own == track) tracked = out;
+			this->m_x[out] = this->m_x[own];
+			this->m_y[out] = this->m_y[own];
+			this->m_percentage[out] = this->m_percentage[own];
+			if (ghosts) this->m_ghost[out] = std::move(this->m_ghost[own]);
+		}
+		else {
+			theirs--;
+			this->m_x[out] = other.m_x[theirs];
+			this->m_y[out] = other.m_y[theirs];
+			this->m_percentage[out] = other.m_percentage[theirs];
+			if (ghosts) this->m_ghost[out] = other.hasGhosts() ?
+				other.m_ghost[theirs] : std::nullopt;
+		}
+	}
+
+	// Everything before own is already in place
+	if (track < own) return track;
+	return tracked;
+}
+
+size_t DeathStore::insert(Vec2 pos, int percentage,
+	std::optional<GhostPose> const& ghost) {
+	size_t index = std::upper_bound(this->m_x.begin(), this->m_x.end(), pos.x) -
+		this->m_x.begin();
+
+	this->m_x.insert(this->m_x.begin() + index, pos.x);
+	this->m_y.insert(this->m_y.begin() + index, pos.y);
+	this->m_percentage.insert(this->m_percentage.begin() + index, percentage);
+	if (this->hasGhosts())
+		this->m_ghost.insert(this->m_ghost.begin() + index, std::nullopt);
+	if (ghost) this->setGhost(index, ghost);
+
+	return index;
+}
+
+void DeathStore::setGhost(size_t index, std::optional<GhostPose> const& ghost) {
+	if (!this->hasGhosts()) {
+		if (!ghost) return;
+		this->m_ghost.resize(this->size());
+	}
+	this->m_ghost[index] = ghost;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "model.hpp"
+
+namespace dm {
+
+	// Columnar list of deaths, kept sorted by x.
+	// Deaths are addressed by their index, which stays valid until the next
+	// insertion or sort.
+	class DeathStore {
+	public:
+		// Index equivalent of nullptr / end()
+		static constexpr size_t npos = SIZE_MAX;
+
+		// Mutable columns of a range of deaths, see extend
+		struct Columns {
+			float* x;
+			float* y;
+			int* percentage;
+		};
+
+		size_t size() const { return this->m_x.size(); }
+		bool empty() const { return this->m_x.empty(); }
+		void clear();
+		void reserve(size_t count);
+		// Drops all deaths from index count onwards
+		void truncate(size_t count);
+		// Drops the deaths with indices in [begin, end)
+		void erase(size_t begin, size_t end);
+
+		float x(size_t index) const { return this->m_x[index]; }
+		float y(size_t index) const { return this->m_y[index]; }
+		Vec2 pos(size_t index) const { return { this->m_x[index], this->m_y[index] }; }
+		int percentage(size_t index) const { return this->m_percentage[index]; }
+		// nullptr if the death was not recorded as a ghost
+		GhostPose const* ghost(size_t index) const;
+		bool hasGhosts() const { return !this->m_ghost.empty(); }
+		DeathEntry entry(size_t index) const;
+
+		std::span<float const> xs() const { return this->m_x; }
+		std::span<float const> ys() const { return this->m_y; }
+		std::span<int const> percentages() const { return this->m_percentage; }
+
+		// Appends without regard for order, call sortByX once done appending
+		void push_back(Vec2 pos, int percentage);
+		void push_back(DeathEntry const& entry);
+		// Appends count zeroed deaths for bulk decoders to fill in place
+		Columns extend(size_t count);
+		// Appends all deaths of other, call sortByX once done appending
+		void append(DeathStore const& other);
+		void sortByX();
+		bool isSorted() const;
+		// Merges the x-sorted deaths of other in a single linear pass. Deaths
+		// already stored go first among equal x. Returns the new index of the
+		// death that was at index track, or npos.
+		size_t merge(DeathStore const& other, size_t track = npos);
+
+		// Inserts while keeping order and returns the index of the new death
+		size_t insert(Vec2 pos, int percentage,
+			std::optional<GhostPose> const& ghost = std::nullopt);
+		void setGhost(size_t index, std::optional<GhostPose> const& ghost);
+
+	private:
+		std::vector<float> m_x;
+		std::vector<float> m_y;
+		std::vector<int> m_percentage;
+		// Side table for ghost poses, empty until the first ghost is added,
+		// afterwards holds one (possibly empty) entry per death
+		std::vector<std::optional<GhostPose>> m_ghost;
+	};
+
+}
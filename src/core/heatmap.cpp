@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+#include "heatmap.hpp"
+
+using namespace dm;
+
+DensityGrid dm::binDeaths(std::span<float const> xs, std::span<float const> ys,
+	float cellSize, int maxCells) {
+
+	DensityGrid grid;
+	if (xs.empty()) return grid;
+
+	auto [minX, maxX] = std::minmax_element(xs.begin(), xs.end());
+	auto [minY, maxY] = std::minmax_element(ys.begin(), ys.end());
+	float const spanX = *maxX - *minX;
+	float const spanY = *maxY - *minY;
+	cellSize = std::max({ cellSize, spanX / maxCells, spanY / maxCells });
+
+	grid.originX = *minX;
+	grid.originY = *minY;
+	grid.cellSize = cellSize;
+	grid.width = std::min(maxCells, static_cast<int>(spanX / cellSize) + 1);
+	grid.height = std::min(maxCells, static_cast<int>(spanY / cellSize) + 1);
+	grid.counts.assign(static_cast<size_t>(grid.width) * grid.height, 0);
+
+	float const inverse = 1 / cellSize;
+	for (size_t i = 0; i < xs.size(); i++) {
+		// Clamped, the maximum can round up to one past the last cell
+		int x = std::min(grid.width - 1,
+			static_cast<int>((xs[i] - grid.originX) * inverse));
+		int y = std::min(grid.height - 1,
+			static_cast<int>((ys[i] - grid.originY) * inverse));
+		grid.counts[y * grid.width + x]++;
+	}
+	grid.maxCount = *std::max_element(grid.counts.begin(), grid.counts.end());
+	return grid;
+
+}
+
+HeatColor dm::heatColor(float density) {
+	return {
+		1 - ((1 - density) * (1 - density)),
+		1 - (density * density),
+		0
+	};
+}
+
+void dm::rasterizeHeatmap(DensityGrid const& grid, int x, int y, int width,
+	int height, uint8_t* out) {
+
+	// Counts span orders of magnitude, so they are scaled logarithmically,
+	// otherwise everything but the worst spot would look empty
+	float const scale = grid.maxCount ?
+		1 / std::log1p(static_cast<float>(grid.maxCount)) : 0;
+
+	// Colours only depend on the count, cells with small ones are common
+	uint8_t lookup[256][4];
+	for (uint32_t count = 0; count < 256; count++) {
+		float density = std::min(1.0f, std::log1p(static_cast<float>(count)) * scale);
+		auto color = heatColor(density);
+		lookup[count][0] = static_cast<uint8_t>(color.r * 255);
+		lookup[count][1] = static_cast<uint8_t>(color.g * 255);
+		lookup[count][2] = static_cast<uint8_t>(color.b * 255);
+		lookup[count][3] = count ? static_cast<uint8_t>(0x60 + density * 0x9f) : 0;
+	}
+
+	for (int row = 0; row < height; row++) {
+		uint32_t const* counts = grid.counts.data() +
+			static_cast<size_t>(y + height - 1 - row) * grid.width + x;
+		uint8_t* pixel = out + static_cast<size_t>(row) * width * 4;
+		for (int column = 0; column < width; column++, pixel += 4) {
+			uint32_t count = counts[column];
+			if (count < 256) {
+				std::copy_n(lookup[count], 4, pixel);
+				continue;
+			}
+			float density = std::min(1.0f, std::log1p(static_cast<float>(count)) * scale);
+			auto color = heatColor(density);
+			pixel[0] = static_cast<uint8_t>(color.r * 255);
+			pixel[1] = static_cast<uint8_t>(color.g * 255);
+			pixel[2] = static_cast<uint8_t>(color.b * 255);
+			pixel[3] = static_cast<uint8_t>(0x60 + density * 0x9f);
+		}
+	}
+
+}
+
+std::vector<HeatmapTile> dm::rasterizeHeatmapTiles(DensityGrid const& grid,
+	int tileSize) {
+
+	std::vector<HeatmapTile> tiles;
+	for (int y = 0; y < grid.height; y += tileSize) {
+		for (int x = 0; x < grid.width; x += tileSize) {
+			HeatmapTile tile;
+			tile.x = x;
+			tile.y = y;
+			tile.width = std::min(tileSize, grid.width - x);
+			tile.height = std::min(tileSize, grid.height - y);
+			tile.pixels.resize(static_cast<size_t>(tile.width) * tile.height * 4);
+			rasterizeHeatmap(grid, x, y, tile.width, tile.height, tile.pixels.data());
+			tiles.push_back(std::move(tile));
+		}
+	}
+	return tiles;
+
+}
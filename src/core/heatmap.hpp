@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Density heatmap for levels with too many deaths to draw as markers.
+// Deaths are counted per cell of a grid, which is then rasterized into
+// RGBA pixels, one per cell, to be drawn as textures scaled up to the
+// cell size.
+
+namespace dm {
+
+	// Deaths counted per square cell of a grid over the level
+	struct DensityGrid {
+		// Lower left corner of cell (0, 0)
+		float originX = 0;
+		float originY = 0;
+		float cellSize = 1;
+		int width = 0;
+		int height = 0;
+		uint32_t maxCount = 0;
+		// Row by row, starting with the lowest row
+		std::vector<uint32_t> counts;
+
+		uint32_t at(int x, int y) const { return this->counts[y * this->width + x]; }
+	};
+
+	// Bins the deaths into a grid covering all of them. cellSize grows as
+	// needed to keep the grid within maxCells cells along either axis, the
+	// default caps the counts at 16 MB however far apart the deaths are.
+	DensityGrid binDeaths(std::span<float const> xs, std::span<float const> ys,
+		float cellSize, int maxCells = 2048);
+
+	// Colour ramp of the progress bar histogram, from green at 0 to red at 1
+	struct HeatColor {
+		float r;
+		float g;
+		float b;
+	};
+	HeatColor heatColor(float density);
+
+	// Writes RGBA8 pixels of cells [x, x + width) x [y, y + height) to out,
+	// which must have room for 4 * width * height bytes. Rows are written
+	// top down, as textures expect them. Empty cells are fully transparent.
+	void rasterizeHeatmap(DensityGrid const& grid, int x, int y, int width,
+		int height, uint8_t* out);
+
+	// Part of a rasterized grid small enough for a single texture
+	struct HeatmapTile {
+		// Lower left cell of the tile
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	// Rasterizes the whole grid in tiles of at most tileSize cells per side
+	std::vector<HeatmapTile> rasterizeHeatmapTiles(DensityGrid const& grid,
+		int tileSize = 1024);
+
+}
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cmath>
+#include "histogram.hpp"
+
+using namespace dm;
+
+void PercentageHistogram::clear() {
+	this->m_counts.fill(0);
+	this->m_maximum = 0;
+	this->m_dirty.set();
+}
+
+void PercentageHistogram::setMaximum(uint32_t maximum) {
+	if (maximum == this->m_maximum) return;
+	this->m_maximum = maximum;
+	this->m_dirty.set();
+}
+
+void PercentageHistogram::add(int percentage) {
+	if (percentage < 0 || percentage >= bins) return;
+	uint32_t count = ++this->m_counts[percentage];
+	this->m_dirty.set(percentage);
+	if (count > this->m_maximum) this->setMaximum(count);
+}
+
+void PercentageHistogram::remove(int percentage) {
+	if (percentage < 0 || percentage >= bins) return;
+	if (this->m_counts[percentage] == 0) return;
+	uint32_t count = this->m_counts[percentage]--;
+	this->m_dirty.set(percentage);
+	// Only a bar at the maximum can lower it, finding the new one is 101 steps
+	if (count == this->m_maximum)
+		this->setMaximum(*std::max_element(this->m_counts.begin(), this->m_counts.end()));
+}
+
+void PercentageHistogram::addAll(std::span<int const> percentages) {
+	for (int percentage : percentages)
+		if (percentage >= 0 && percentage < bins) this->m_counts[percentage]++;
+	this->m_dirty.set();
+	this->m_maximum = *std::max_element(this->m_counts.begin(), this->m_counts.end());
+}
+
+void PercentageHistogram::removeAll(std::span<int const> percentages) {
+	for (int percentage : percentages)
+		if (percentage >= 0 && percentage < bins && this->m_counts[percentage])
+			this->m_counts[percentage]--;
+	this->m_dirty.set();
+	this->m_maximum = *std::max_element(this->m_counts.begin(), this->m_counts.end());
+}
+
+std::bitset<PercentageHistogram::bins> PercentageHistogram::takeDirty() {
+	auto dirty = this->m_dirty;
+	this->m_dirty.reset();
+	return dirty;
+}
+
+void TimeHistogram::clear() {
+	this->m_sketch.clear();
+	this->m_counts.fill(0);
+	this->m_maximum = 0;
+	this->m_dirty.set();
+	this->m_columnWidth = 1;
+	this->m_laidOut = 0;
+	this->m_outside = 0;
+}
+
+void TimeHistogram::setMaximum(uint32_t maximum) {
+	if (maximum == this->m_maximum) return;
+	this->m_maximum = maximum;
+	this->m_dirty.set();
+}
+
+int TimeHistogram::columnOf(int seconds) const {
+	// Through the sketch, so a death lands in the same column as it does
+	// when laid out from the sketch's buckets
+	double column = std::floor(this->m_sketch.bucketValue(seconds) / this->m_columnWidth);
+	return column < columns ? static_cast<int>(column) : columns;
+}
+
+void TimeHistogram::add(int seconds) {
+	// Deaths without an attempt time stay out of the chart
+	if (seconds < 0) return;
+	this->m_sketch.add(seconds);
+	int const column = this->columnOf(seconds);
+	if (column == columns) {
+		this->m_outside++;
+		return;
+	}
+	uint32_t count = ++this->m_counts[column];
+	this->m_dirty.set(column);
+	if (count > this->m_maximum) this->setMaximum(count);
+}
+
+void TimeHistogram::remove(int seconds) {
+	if (seconds < 0) return;
+	if (!this->m_sketch.remove(seconds)) return;
+	int const column = this->columnOf(seconds);
+	if (column == columns) {
+		if (this->m_outside) this->m_outside--;
+		return;
+	}
+	if (this->m_counts[column] == 0) return;
+	uint32_t count = this->m_counts[column]--;
+	this->m_dirty.set(column);
+	if (count == this->m_maximum)
+		this->setMaximum(*std::max_element(this->m_counts.begin(), this->m_counts.end()));
+}
+
+void TimeHistogram::addAll(std::span<int const> times) {
+	for (int seconds : times) {
+		if (seconds < 0) continue;
+		this->m_sketch.add(seconds);
+		int const column = this->columnOf(seconds);
+		if (column == columns) this->m_outside++;
+		else this->m_counts[column]++;
+	}
+	this->m_dirty.set();
+	this->m_maximum = *std::max_element(this->m_counts.begin(), this->m_counts.end());
+}
+
+void TimeHistogram::removeAll(std::span<int const> times) {
+	for (int seconds : times) {
+		if (seconds < 0 || !this->m_sketch.remove(seconds)) continue;
+		int const column = this->columnOf(seconds);
+		if (column == columns) {
+			if (this->m_outside) this->m_outside--;
+		}
+		else if (this->m_counts[column]) this->m_counts[column]--;
+	}
+	this->m_dirty.set();
+	this->m_maximum = *std::max_element(this->m_counts.begin(), this->m_counts.end());
+}
+
+bool TimeHistogram::needsLayout() const {
+	uint64_t const count = this->m_sketch.count();
+	// Laying out leaves about 1% of deaths outside, so this takes at least
+	// another 1% of deaths, and doubling or halving takes as many again.
+	// Both keep the cost of laying out constant per death.
+	return count > this->m_laidOut * 2 || count * 2 < this->m_laidOut ||
+		this->m_outside * 50 > count;
+}
+
+void TimeHistogram::layout() {
+	double const end = std::max(this->m_sketch.quantile(0.99) * 1.05,
+		static_cast<double>(columns));
+	this->m_columnWidth = end / columns;
+
+	this->m_counts.fill(0);
+	this->m_outside = 0;
+	this->m_sketch.forEachBucket([this](double value, uint32_t count) {
+		double column = std::floor(value / this->m_columnWidth);
+		if (column < columns) this->m_counts[static_cast<int>(column)] += count;
+		else this->m_outside += count;
+	});
+	this->m_laidOut = this->m_sketch.count();
+	this->m_maximum = *std::max_element(this->m_counts.begin(), this->m_counts.end());
+	this->m_dirty.set();
+}
+
+std::bitset<TimeHistogram::columns> TimeHistogram::takeDirty() {
+	if (this->needsLayout()) this->layout();
+	auto dirty = this->m_dirty;
+	this->m_dirty.reset();
+	return dirty;
+}
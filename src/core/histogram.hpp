@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <span>
+#include "sketch.hpp"
+
+namespace dm {
+
+	// Deaths per percentage of a normal level, kept up to date as deaths
+	// come and go, so showing it never needs to look at all deaths. Tracks
+	// which bars changed since they were last drawn.
+	class PercentageHistogram {
+	public:
+		// Percentages 0 to 100, anything else is not counted
+		static constexpr int bins = 101;
+
+		void clear();
+		void add(int percentage);
+		void remove(int percentage);
+		void addAll(std::span<int const> percentages);
+		void removeAll(std::span<int const> percentages);
+
+		uint32_t count(int percentage) const { return this->m_counts[percentage]; }
+		// Largest count of any percentage, bars are drawn relative to it
+		uint32_t maximum() const { return this->m_maximum; }
+
+		// Percentages whose bar changed since the last call. When the maximum
+		// changes, so do all bars.
+		std::bitset<bins> takeDirty();
+		void markAllDirty() { this->m_dirty.set(); }
+
+	private:
+		std::array<uint32_t, bins> m_counts{};
+		uint32_t m_maximum = 0;
+		std::bitset<bins> m_dirty;
+
+		void setMaximum(uint32_t maximum);
+	};
+
+	// Deaths per attempt time of a platformer level, in columns of equal
+	// width covering all but the slowest percent of deaths. Where the columns
+	// end comes from a quantile sketch of all times, so it is known without
+	// sorting them. Columns are only laid out again once the times drifted
+	// away from them, otherwise a death only changes its own column.
+	class TimeHistogram {
+	public:
+		static constexpr int columns = 50;
+
+		void clear();
+		void add(int seconds);
+		void remove(int seconds);
+		void addAll(std::span<int const> times);
+		void removeAll(std::span<int const> times);
+
+		uint32_t count(int column) const { return this->m_counts[column]; }
+		uint32_t maximum() const { return this->m_maximum; }
+		// Attempt time at the end of the last column
+		double rangeEnd() const { return this->m_columnWidth * columns; }
+
+		// Columns that changed since the last call, after laying them out
+		// again if needed
+		std::bitset<columns> takeDirty();
+		void markAllDirty() { this->m_dirty.set(); }
+
+	private:
+		QuantileSketch m_sketch;
+		std::array<uint32_t, columns> m_counts{};
+		uint32_t m_maximum = 0;
+		std::bitset<columns> m_dirty;
+		double m_columnWidth = 1;
+		// Deaths counted when the columns were laid out
+		uint64_t m_laidOut = 0;
+		// Deaths past the last column
+		uint64_t m_outside = 0;
+
+		// columns if past the last one
+		int columnOf(int seconds) const;
+		bool needsLayout() const;
+		void layout();
+		void setMaximum(uint32_t maximum);
+	};
+
+}
@@ -0,0 +1,202 @@
+#include <cstring>
+#include "journal.hpp"
+#include "mappedFile.hpp"
+
+using namespace dm;
+
+namespace {
+
+	char const journalMagic[4] = { 'D', 'M', 'L', 'J' };
+	uint16_t const journalVersion = 1;
+
+	// Records always hold the percentage, or the attempt time on platformer
+	// levels, so every journal is written with HasPercentage
+	enum JournalFlags : uint16_t {
+		HasPercentage = 1 << 0
+	};
+
+	struct JournalHeader {
+		char magic[4];
+		uint16_t version;
+		uint16_t flags;
+		// Number of deaths in the save this journal was started on top of
+		uint64_t baseCount;
+	};
+	static_assert(sizeof(JournalHeader) == 16);
+
+	struct JournalRecord {
+		float x;
+		float y;
+		int32_t percentage;
+		float rotation;
+		uint8_t mode;
+		uint8_t flagField;
+		uint8_t hasGhost;
+		uint8_t reserved;
+	};
+	static_assert(sizeof(JournalRecord) == 20);
+
+	bool checkHeader(ByteSpan data, size_t baseCount, JournalHeader* header) {
+		if (data.size() < sizeof(JournalHeader)) return false;
+		std::memcpy(header, data.data(), sizeof(JournalHeader));
+		return std::memcmp(header->magic, journalMagic, sizeof(journalMagic)) == 0 &&
+			header->version == journalVersion && header->baseCount == baseCount;
+	}
+
+	// Number of whole records in a journal, a record cut off by a crash
+	// mid-write does not count
+	size_t recordCount(ByteSpan data) {
+		return (data.size() - sizeof(JournalHeader)) / sizeof(JournalRecord);
+	}
+
+}
+
+DeathJournal::~DeathJournal() {
+	this->close();
+}
+
+bool DeathJournal::open(std::filesystem::path const& filePath,
+	size_t baseCount) {
+
+	this->close();
+
+	size_t validSize = 0;
+	{
+		MappedFile file;
+		JournalHeader header;
+		if (file.open(filePath) && checkHeader(file.data(), baseCount, &header)) {
+			validSize = sizeof(header) + recordCount(file.data()) * sizeof(JournalRecord);
+		}
+	}
+
+	std::error_code error;
+	if (validSize) std::filesystem::resize_file(filePath, validSize, error);
+
+	if (validSize && !error) {
+		this->m_stream.open(filePath, std::ios::binary | std::ios::app);
+	}
+	else {
+		this->m_stream.open(filePath, std::ios::binary | std::ios::trunc);
+		JournalHeader header;
+		std::memcpy(header.magic, journalMagic, sizeof(journalMagic));
+		header.version = journalVersion;
+		header.flags = HasPercentage;
+		header.baseCount = baseCount;
+		this->m_stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		this->m_stream.flush();
+	}
+	if (!this->m_stream) {
+		this->m_stream.close();
+		return false;
+	}
+
+	this->m_stop = false;
+	this->m_appended = 0;
+	this->m_flushed = 0;
+	this->m_writer = std::thread(&DeathJournal::run, this);
+	return true;
+}
+
+void DeathJournal::close() {
+	if (!this->isOpen()) return;
+	{
+		std::lock_guard lock(this->m_mutex);
+		this->m_stop = true;
+	}
+	this->m_wake.notify_one();
+	this->m_writer.join();
+	this->m_stream.close();
+}
+
+void DeathJournal::append(DeathEntry const& entry) {
+	if (!this->isOpen()) return;
+	{
+		std::lock_guard lock(this->m_mutex);
+		this->m_pending.push_back(entry);
+		this->m_appended++;
+	}
+	this->m_wake.notify_one();
+}
+
+void DeathJournal::flush() {
+	if (!this->isOpen()) return;
+	std::unique_lock lock(this->m_mutex);
+	this->m_written.wait(lock, [this] {
+		return this->m_flushed == this->m_appended;
+	});
+}
+
+void DeathJournal::run() {
+	std::vector<DeathEntry> batch;
+	std::vector<JournalRecord> records;
+
+	std::unique_lock lock(this->m_mutex);
+	while (true) {
+		this->m_wake.wait(lock, [this] {
+			return this->m_stop || !this->m_pending.empty();
+		});
+		if (this->m_pending.empty()) break;
+
+		// Deaths appended while this batch is written make up the next one
+		batch.swap(this->m_pending);
+		lock.unlock();
+
+		records.assign(batch.size(), JournalRecord{});
+		for (size_t i = 0; i < batch.size(); i++) {
+			auto& record = records[i];
+			record.x = batch[i].pos.x;
+			record.y = batch[i].pos.y;
+			record.percentage = batch[i].percentage;
+			if (auto& ghost = batch[i].ghost) {
+				record.rotation = ghost->rotation;
+				record.mode = static_cast<uint8_t>(ghost->mode);
+				record.flagField = ghost->flagField();
+				record.hasGhost = 1;
+			}
+		}
+		this->m_stream.write(reinterpret_cast<char const*>(records.data()),
+			records.size() * sizeof(JournalRecord));
+		this->m_stream.flush();
+
+		lock.lock();
+		this->m_flushed += batch.size();
+		batch.clear();
+		this->m_written.notify_all();
+	}
+}
+
+size_t dm::readJournal(std::filesystem::path const& filePath,
+	size_t baseCount, DeathStore* target) {
+
+	MappedFile file;
+	JournalHeader header;
+	if (!file.open(filePath) || !checkHeader(file.data(), baseCount, &header))
+		return 0;
+
+	size_t const count = recordCount(file.data());
+	uint8_t const* data = file.data().data() + sizeof(header);
+	target->reserve(target->size() + count);
+	for (size_t i = 0; i < count; i++, data += sizeof(JournalRecord)) {
+		JournalRecord record;
+		std::memcpy(&record, data, sizeof(record));
+
+		DeathEntry entry;
+		entry.pos = { record.x, record.y };
+		entry.percentage = record.percentage;
+		if (record.hasGhost) {
+			GhostPose pose;
+			pose.rotation = record.rotation;
+			pose.mode = record.mode;
+			pose.setFlags(record.flagField);
+			entry.ghost = pose;
+		}
+		target->push_back(entry);
+	}
+
+	target->sortByX();
+	return count;
+}
+
+bool dm::shouldCompact(size_t baseCount, size_t journalCount) {
+	return journalCount >= 4096 || journalCount * 8 > baseCount;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "model.hpp"
+#include "deathStore.hpp"
+
+namespace dm {
+
+	// Append-only log of deaths added on top of a binary local save.
+	// Records are handed to a background thread that writes them in batches,
+	// so deaths of a session survive a crash without rewriting the save.
+	// See "Local Deaths" in docs/doc.md for the format.
+	class DeathJournal {
+	public:
+		DeathJournal() = default;
+		DeathJournal(DeathJournal const&) = delete;
+		DeathJournal& operator=(DeathJournal const&) = delete;
+		~DeathJournal();
+
+		// Continues the journal at filePath if it belongs to a save holding
+		// baseCount deaths, otherwise starts a new one.
+		// Returns false if the file could not be opened for writing.
+		bool open(std::filesystem::path const& filePath, size_t baseCount);
+		// Writes everything appended so far and stops the writer
+		void close();
+		bool isOpen() const { return this->m_writer.joinable(); }
+
+		// Does not block on disk access
+		void append(DeathEntry const& entry);
+		// Blocks until everything appended so far is written
+		void flush();
+
+	private:
+		std::ofstream m_stream;
+		std::thread m_writer;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_written;
+		std::vector<DeathEntry> m_pending;
+		size_t m_appended = 0;
+		size_t m_flushed = 0;
+		bool m_stop = false;
+
+		void run();
+	};
+
+	// Appends the deaths of the journal at filePath to target and sorts it,
+	// unless the journal does not belong to a save holding baseCount deaths.
+	// Returns the number of deaths appended.
+	size_t readJournal(std::filesystem::path const& filePath, size_t baseCount,
+		DeathStore* target);
+
+	// Whether a journal has grown large enough relative to its save that
+	// folding it into the save is worth a full rewrite
+	bool shouldCompact(size_t baseCount, size_t journalCount);
+
+}
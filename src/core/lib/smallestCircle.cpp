@@ -34,18 +34,18 @@ using namespace dm;
 
 /*---- Members of struct Circle ----*/
 
-const Circle Circle::INVALID{CCPoint{0, 0}, -1};
+const Circle Circle::INVALID{Vec2{0, 0}, -1};
 
 const double Circle::MULTIPLICATIVE_EPSILON = 1 + 1e-14;
 
 
-bool Circle::contains(const CCPoint &p) const {
+bool Circle::contains(const Vec2 &p) const {
 	return c.getDistance(p) <= r * MULTIPLICATIVE_EPSILON;
 }
 
 
-bool Circle::contains(const vector<CCPoint> &ps) const {
-	for (const CCPoint &p : ps) {
+bool Circle::contains(const vector<Vec2> &ps) const {
+	for (const Vec2 &p : ps) {
 		if (!contains(p))
 			return false;
 	}
@@ -55,21 +55,21 @@ bool Circle::contains(const vector<CCPoint> &ps) const {
 
 /*---- Smallest enclosing circle algorithm ----*/
 
-static Circle makeSmallestEnclosingCircleOnePoint (const vector<CCPoint> &points, size_t end, const CCPoint &p);
-static Circle makeSmallestEnclosingCircleTwoPoints(const vector<CCPoint> &points, size_t end, const CCPoint &p, const CCPoint &q);
+static Circle makeSmallestEnclosingCircleOnePoint (const vector<Vec2> &points, size_t end, const Vec2 &p);
+static Circle makeSmallestEnclosingCircleTwoPoints(const vector<Vec2> &points, size_t end, const Vec2 &p, const Vec2 &q);
 
 static std::default_random_engine randGen((std::random_device())());
 
 
 // Initially: No boundary points known
-Circle dm::makeSmallestEnclosingCircle(vector<CCPoint> points) {
+Circle dm::makeSmallestEnclosingCircle(vector<Vec2> points) {
 	// Randomize order
 	std::shuffle(points.begin(), points.end(), randGen);
 
 	// Progressively add points to circle or recompute circle
 	Circle c = Circle::INVALID;
 	for (size_t i = 0; i < points.size(); i++) {
-		const CCPoint &p = points.at(i);
+		const Vec2 &p = points.at(i);
 		if (c.r < 0 || !c.contains(p))
 			c = makeSmallestEnclosingCircleOnePoint(points, i + 1, p);
 	}
@@ -78,10 +78,10 @@ Circle dm::makeSmallestEnclosingCircle(vector<CCPoint> points) {
 
 
 // One boundary point known
-static Circle makeSmallestEnclosingCircleOnePoint(const vector<CCPoint> &points, size_t end, const CCPoint &p) {
+static Circle makeSmallestEnclosingCircleOnePoint(const vector<Vec2> &points, size_t end, const Vec2 &p) {
 	Circle c{p, 0};
 	for (size_t i = 0; i < end; i++) {
-		const CCPoint &q = points.at(i);
+		const Vec2 &q = points.at(i);
 		if (!c.contains(q)) {
 			if (c.r == 0)
 				c = dm::makeDiameter(p, q);
@@ -94,15 +94,15 @@ static Circle makeSmallestEnclosingCircleOnePoint(const vector<CCPoint> &points,
 
 
 // Two boundary points known
-static Circle makeSmallestEnclosingCircleTwoPoints(const vector<CCPoint> &points, size_t end, const CCPoint &p, const CCPoint &q) {
+static Circle makeSmallestEnclosingCircleTwoPoints(const vector<Vec2> &points, size_t end, const Vec2 &p, const Vec2 &q) {
 	Circle circ = dm::makeDiameter(p, q);
 	Circle left  = Circle::INVALID;
 	Circle right = Circle::INVALID;
 
 	// For each point not in the two-point circle
-	CCPoint pq = q - p;
+	Vec2 pq = q - p;
 	for (size_t i = 0; i < end; i++) {
-		const CCPoint &r = points.at(i);
+		const Vec2 &r = points.at(i);
 		if (circ.contains(r))
 			continue;
 
@@ -129,13 +129,13 @@ static Circle makeSmallestEnclosingCircleTwoPoints(const vector<CCPoint> &points
 }
 
 
-Circle dm::makeDiameter(const CCPoint &a, const CCPoint &b) {
-	CCPoint c{(a.x + b.x) / 2, (a.y + b.y) / 2};
+Circle dm::makeDiameter(const Vec2 &a, const Vec2 &b) {
+	Vec2 c{(a.x + b.x) / 2, (a.y + b.y) / 2};
 	return Circle{c, max(c.getDistance(a), c.getDistance(b))};
 }
 
 
-Circle dm::makeCircumcircle(const CCPoint &a, const CCPoint &b, const CCPoint &c) {
+Circle dm::makeCircumcircle(const Vec2 &a, const Vec2 &b, const Vec2 &c) {
 	// Mathematical algorithm from Wikipedia: Circumscribed circle
 	float ox = (min(min(a.x, b.x), c.x) + max(max(a.x, b.x), c.x)) / 2;
 	float oy = (min(min(a.y, b.y), c.y) + max(max(a.y, b.y), c.y)) / 2;
@@ -147,7 +147,7 @@ Circle dm::makeCircumcircle(const CCPoint &a, const CCPoint &b, const CCPoint &c
 		return Circle::INVALID;
 	float x = ((ax*ax + ay*ay) * (by - cy) + (bx*bx + by*by) * (cy - ay) + (cx*cx + cy*cy) * (ay - by)) / d;
 	float y = ((ax*ax + ay*ay) * (cx - bx) + (bx*bx + by*by) * (ax - cx) + (cx*cx + cy*cy) * (bx - ax)) / d;
-	CCPoint p{ox + x, oy + y};
+	Vec2 p{ox + x, oy + y};
 	float r = max(max(p.getDistance(a), p.getDistance(b)), p.getDistance(c));
 	return Circle{p, r};
 }
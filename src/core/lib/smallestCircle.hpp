@@ -22,7 +22,7 @@
 #pragma once
 
 #include <vector>
-#include "../shared.hpp"
+#include "../model.hpp"
 
 
 namespace dm {
@@ -33,13 +33,13 @@ namespace dm {
 
 		private: static const double MULTIPLICATIVE_EPSILON;
 
-		public: CCPoint c;   // Center
+		public: Vec2 c;   // Center
 		public: float r = 0;  // Radius
 
 
-		public: bool contains(const CCPoint &p) const;
+		public: bool contains(const Vec2 &p) const;
 
-		public: bool contains(const std::vector<CCPoint> &ps) const;
+		public: bool contains(const std::vector<Vec2> &ps) const;
 
 	};
 
@@ -49,10 +49,10 @@ namespace dm {
 	 * Runs in expected O(n) time, randomized. Note: If 0 points are given, a circle of
 	 * negative radius is returned. If 1 point is given, a circle of radius 0 is returned.
 	 */
-	Circle makeSmallestEnclosingCircle(std::vector<CCPoint> points);
+	Circle makeSmallestEnclosingCircle(std::vector<Vec2> points);
 
 	// For unit tests
-	Circle makeDiameter(const CCPoint &a, const CCPoint &b);
-	Circle makeCircumcircle(const CCPoint &a, const CCPoint &b, const CCPoint &c);
+	Circle makeDiameter(const Vec2 &a, const Vec2 &b);
+	Circle makeCircumcircle(const Vec2 &a, const Vec2 &b, const Vec2 &c);
 
 }
\ No newline at end of file
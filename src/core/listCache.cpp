@@ -0,0 +1,59 @@
+#include <charconv>
+#include <fstream>
+#include "listCache.hpp"
+#include "local.hpp"
+
+using namespace dm;
+
+static std::filesystem::path tagPath(std::filesystem::path const& filePath) {
+	auto path = filePath;
+	path += ".etag";
+	return path;
+}
+
+std::optional<ListCacheTag> dm::readListCacheTag(
+	std::filesystem::path const& filePath) {
+
+	std::error_code error;
+	if (!std::filesystem::exists(filePath, error)) return std::nullopt;
+
+	auto stream = std::ifstream(tagPath(filePath), std::ios::binary);
+	if (!stream) return std::nullopt;
+
+	// ETag on the first line, cursor on the second
+	ListCacheTag tag;
+	std::string cursor;
+	std::getline(stream, tag.etag);
+	std::getline(stream, cursor);
+	if (tag.etag.empty()) return std::nullopt;
+
+	auto result = std::from_chars(cursor.data(), cursor.data() + cursor.size(),
+		tag.cursor);
+	if (result.ec != std::errc()) tag.cursor = 0;
+	return tag;
+}
+
+bool dm::readListCache(std::filesystem::path const& filePath,
+	DeathStore* target) {
+	return readLocalDeaths(filePath, target) == LocalStatus::Ok;
+}
+
+bool dm::writeListCache(std::filesystem::path const& filePath,
+	DeathStore const& deaths, bool hasPercentage, ListCacheTag const& tag) {
+
+	// Drop the tag first, so a failed write can never pair an old list
+	// with a new tag
+	std::error_code error;
+	std::filesystem::remove(tagPath(filePath), error);
+	if (!writeLocalDeaths(filePath, deaths, hasPercentage)) return false;
+
+	auto stream = std::ofstream(tagPath(filePath), std::ios::binary | std::ios::trunc);
+	stream << tag.etag << '\n' << tag.cursor << '\n';
+	stream.close();
+	return !stream.fail();
+}
+
+void dm::dropListCache(std::filesystem::path const& filePath) {
+	std::error_code error;
+	std::filesystem::remove(tagPath(filePath), error);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include "deathStore.hpp"
+
+// On-disk copies of decoded /list responses. The deaths are stored as a
+// binary local save, so a cache hit is a single mapped read, and the ETag
+// they were served with sits next to them for revalidation, along with the
+// cursor that lets later requests ask for newer deaths only.
+
+namespace dm {
+
+	struct ListCacheTag {
+		std::string etag;
+		// Id of the newest death included in the cache, 0 if unknown
+		uint64_t cursor = 0;
+	};
+
+	// Tag of the cached list, nothing if there is no usable cache
+	std::optional<ListCacheTag> readListCacheTag(
+		std::filesystem::path const& filePath);
+	// Appends the cached deaths to target and sorts it
+	bool readListCache(std::filesystem::path const& filePath, DeathStore* target);
+	bool writeListCache(std::filesystem::path const& filePath,
+		DeathStore const& deaths, bool hasPercentage, ListCacheTag const& tag);
+	// Makes the cache unusable, e.g. after it failed to be read
+	void dropListCache(std::filesystem::path const& filePath);
+
+}
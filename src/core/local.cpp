@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "local.hpp"
+#include "mappedFile.hpp"
+
+using namespace dm;
+
+static_assert(sizeof(float) == 4 && sizeof(int) == 4,
+	"Local saves store columns as they are laid out in memory");
+
+namespace {
+
+	char const localMagic[4] = { 'D', 'M', 'L', 'D' };
+	uint16_t const localVersion = 1;
+
+	enum LocalFlags : uint16_t {
+		HasPercentage = 1 << 0,
+		HasGhosts = 1 << 1
+	};
+
+	struct LocalHeader {
+		char magic[4];
+		uint16_t version;
+		uint16_t flags;
+		uint64_t count;
+	};
+	static_assert(sizeof(LocalHeader) == 16);
+
+	struct LocalGhost {
+		float rotation;
+		uint8_t mode;
+		uint8_t flagField;
+		uint8_t present;
+		uint8_t reserved;
+	};
+	static_assert(sizeof(LocalGhost) == 8);
+
+}
+
+LocalStatus dm::readLocalDeaths(std::filesystem::path const& filePath,
+	DeathStore* target) {
+
+	MappedFile file;
+	if (!file.open(filePath)) return LocalStatus::Missing;
+	auto data = file.data();
+
+	LocalHeader header;
+	if (data.size() < sizeof(header)) return LocalStatus::Corrupt;
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (std::memcmp(header.magic, localMagic, sizeof(localMagic)) != 0 ||
+		header.version != localVersion) return LocalStatus::Corrupt;
+
+	bool const hasPercentage = header.flags & HasPercentage;
+	bool const hasGhosts = header.flags & HasGhosts;
+	size_t const recordWidth = 4 + 4 + (hasPercentage ? 4 : 0) +
+		(hasGhosts ? sizeof(LocalGhost) : 0);
+	// Also guards the size computation below against overflow
+	if (header.count > data.size() / recordWidth) return LocalStatus::Corrupt;
+	size_t const count = static_cast<size_t>(header.count);
+	if (data.size() != sizeof(header) + count * recordWidth)
+		return LocalStatus::Corrupt;
+	if (!count) return LocalStatus::Ok;
+
+	// Columns are stored back to back in the same layout as in DeathStore
+	size_t const start = target->size();
+	auto columns = target->extend(count);
+	uint8_t const* section = data.data() + sizeof(header);
+	std::memcpy(columns.x, section, count * 4);
+	section += count * 4;
+	std::memcpy(columns.y, section, count * 4);
+	section += count * 4;
+	if (hasPercentage) {
+		std::memcpy(columns.percentage, section, count * 4);
+		section += count * 4;
+	}
+	else std::fill_n(columns.percentage, count, noPercentage);
+
+	if (hasGhosts) {
+		for (size_t i = 0; i < count; i++, section += sizeof(LocalGhost)) {
+			LocalGhost ghost;
+			std::memcpy(&ghost, section, sizeof(ghost));
+			if (!ghost.present) continue;
+			GhostPose pose;
+			pose.rotation = ghost.rotation;
+			pose.mode = ghost.mode;
+			pose.setFlags(ghost.flagField);
+			target->setGhost(start + i, pose);
+		}
+	}
+
+	target->sortByX();
+	return LocalStatus::Ok;
+}
+
+bool dm::writeLocalDeaths(std::filesystem::path const& filePath,
+	DeathStore const& deaths, bool hasPercentage) {
+
+	LocalHeader header;
+	std::memcpy(header.magic, localMagic, sizeof(localMagic));
+	header.version = localVersion;
+	header.flags = (hasPercentage ? HasPercentage : 0) |
+		(deaths.hasGhosts() ? HasGhosts : 0);
+	header.count = deaths.size();
+
+	// Write next to the save and swap it in, so a crash mid-write
+	// does not cost the player all their deaths
+	auto tempPath = filePath;
+	tempPath += ".tmp";
+	{
+		auto stream = std::ofstream(tempPath, std::ios::binary | std::ios::trunc);
+		auto writeColumn = [&stream](auto column) {
+			stream.write(reinterpret_cast<char const*>(column.data()),
+				column.size_bytes());
+		};
+
+		stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		writeColumn(deaths.xs());
+		writeColumn(deaths.ys());
+		if (hasPercentage) writeColumn(deaths.percentages());
+
+		if (deaths.hasGhosts()) {
+			std::vector<LocalGhost> ghosts(deaths.size(), LocalGhost{});
+			for (size_t i = 0; i < deaths.size(); i++) {
+				auto pose = deaths.ghost(i);
+				if (!pose) continue;
+				ghosts[i].rotation = pose->rotation;
+				ghosts[i].mode = static_cast<uint8_t>(pose->mode);
+				ghosts[i].flagField = pose->flagField();
+				ghosts[i].present = 1;
+			}
+			writeColumn(std::span<LocalGhost const>(ghosts));
+		}
+
+		stream.close();
+		if (stream.fail()) {
+			std::error_code error;
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, filePath, error);
+	return !error;
+}
+
+// Returns the end of the parsed number, or nullptr if there is none
+static char const* parseFloat(char const* begin, char const* end, float* value) {
+#ifdef __cpp_lib_to_chars
+	auto result = std::from_chars(begin, end, *value);
+	return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+	// Some standard libraries lack floating point from_chars
+	char buffer[64];
+	size_t length = std::min<size_t>(end - begin, sizeof(buffer) - 1);
+	std::memcpy(buffer, begin, length);
+	buffer[length] = '\0';
+
+	char* parsed;
+	errno = 0;
+	*value = std::strtof(buffer, &parsed);
+	if (parsed == buffer || errno == ERANGE) return nullptr;
+	return begin + (parsed - buffer);
+#endif
+}
+
+std::optional<DeathEntry> dm::readCSVLine(std::string_view line,
+	bool hasPercentage) {
+
+	char const* it = line.data();
+	char const* end = it + line.size();
+	if (it != end && end[-1] == '\r') end--;
+	if (it == end) return std::nullopt;
+
+	// Every value is read as float, the integers in a save are far below 2^24
+	float values[6];
+	size_t count = 0;
+	while (true) {
+		if (count == std::size(values)) return std::nullopt;
+		it = parseFloat(it, end, &values[count++]);
+		if (!it) return std::nullopt;
+		if (it == end) break;
+		if (*it++ != ',') return std::nullopt;
+	}
+
+	bool isGhost = count > 3;
+	size_t expect = (hasPercentage ? 3 : 2) + (isGhost * 3);
+	if (count != expect) return std::nullopt;
+
+	DeathEntry entry;
+	entry.pos = { values[0], values[1] };
+
+	// If applicable, extract percentage
+	if (hasPercentage)
+		entry.percentage = static_cast<int>(values[isGhost ? 5 : 2]);
+	else entry.percentage = noPercentage;
+
+	if (isGhost) {
+		GhostPose pose;
+		pose.rotation = values[2];
+		pose.mode = static_cast<int>(values[3]);
+		pose.setFlags(static_cast<uint8_t>(values[4]));
+		entry.ghost = pose;
+	}
+
+	return entry;
+}
+
+void dm::printCSV(std::ostream& os, DeathEntry const& entry,
+	bool hasPercentage) {
+	os << entry.pos.x << ',' << entry.pos.y;
+	if (entry.ghost) {
+		os << ',' << entry.ghost->rotation << ',' << entry.ghost->mode << ','
+			<< static_cast<int>(entry.ghost->flagField());
+	}
+	if (hasPercentage) os << ',' << entry.percentage;
+}
+
+size_t dm::readCSVDeaths(std::string_view buffer, bool hasPercentage,
+	DeathStore* target) {
+	size_t rejected = 0;
+
+	while (!buffer.empty()) {
+		size_t lineEnd = buffer.find('\n');
+		auto line = buffer.substr(0, lineEnd);
+		buffer.remove_prefix(lineEnd == std::string_view::npos ?
+			buffer.size() : lineEnd + 1);
+
+		if (line.empty() || line == "\r") continue;
+		auto entry = readCSVLine(line, hasPercentage);
+		if (entry.has_value()) target->push_back(*entry);
+		else rejected++;
+	}
+
+	return rejected;
+}
+
+size_t dm::parseCSVDeathList(std::string_view body, DeathStore* target,
+	bool hasPercentage) {
+	size_t headerEnd = body.find('\n');
+	if (headerEnd == std::string_view::npos) return 0;
+	return readCSVDeaths(body.substr(headerEnd + 1), hasPercentage, target);
+}
+
+size_t dm::readLocalDeathsCSV(std::filesystem::path const& filePath,
+	bool hasPercentage, DeathStore* target) {
+	MappedFile file;
+	if (!file.open(filePath)) return 0;
+
+	auto data = file.data();
+	auto rejected = readCSVDeaths(std::string_view(
+		reinterpret_cast<char const*>(data.data()), data.size()
+	), hasPercentage, target);
+
+	target->sortByX();
+	return rejected;
+}
+
+void dm::writeLocalDeathsCSV(std::filesystem::path const& filePath,
+	DeathStore const& deaths, bool hasPercentage) {
+	auto stream = std::ofstream(filePath);
+	for (size_t i = 0; i < deaths.size(); i++) {
+		printCSV(stream, deaths.entry(i), hasPercentage);
+		stream << '\n';
+	}
+}
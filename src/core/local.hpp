@@ -0,0 +1,50 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include "model.hpp"
+#include "deathStore.hpp"
+
+namespace dm {
+
+	enum class LocalStatus {
+		Ok,
+		// No save exists (yet) or it could not be opened
+		Missing,
+		// Not a binary local save, or of a version this client does not know
+		Corrupt
+	};
+
+	// Appends all deaths stored in the binary save to target and sorts it by x.
+	// See "Local Deaths" in docs/doc.md for the format.
+	LocalStatus readLocalDeaths(std::filesystem::path const& filePath,
+		DeathStore* target);
+	// Replaces the file as a whole, returns false if it could not be written
+	bool writeLocalDeaths(std::filesystem::path const& filePath,
+		DeathStore const& deaths, bool hasPercentage);
+
+	// CSV saves of earlier versions, only read to migrate them, and csv
+	// responses of /list, which use the same layout below a header line
+
+	// Parses one line without its line break
+	std::optional<DeathEntry> readCSVLine(std::string_view line,
+		bool hasPercentage);
+	void printCSV(std::ostream& os, DeathEntry const& entry, bool hasPercentage);
+
+	// Appends all deaths in buffer to target without sorting it
+	// Returns the number of lines that could not be parsed
+	size_t readCSVDeaths(std::string_view buffer, bool hasPercentage,
+		DeathStore* target);
+	// Same as readCSVDeaths, but skips the header line of a csv /list response
+	size_t parseCSVDeathList(std::string_view body, DeathStore* target,
+		bool hasPercentage);
+
+	// Appends all deaths stored in the file to target and sorts it by x
+	// Returns the number of lines that could not be parsed
+	size_t readLocalDeathsCSV(std::filesystem::path const& filePath,
+		bool hasPercentage, DeathStore* target);
+	void writeLocalDeathsCSV(std::filesystem::path const& filePath,
+		DeathStore const& deaths, bool hasPercentage);
+
+}
@@ -0,0 +1,123 @@
+#include <utility>
+#include "mappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace dm;
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this == &other) return *this;
+	this->close();
+	this->m_data = std::exchange(other.m_data, nullptr);
+	this->m_size = std::exchange(other.m_size, 0);
+	this->m_open = std::exchange(other.m_open, false);
+#ifdef _WIN32
+	this->m_file = std::exchange(other.m_file, nullptr);
+	this->m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	this->close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(std::filesystem::path const& filePath) {
+	this->close();
+
+	HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		return false;
+	}
+	this->m_file = file;
+	this->m_open = true;
+	// Zero-length files cannot be mapped
+	if (size.QuadPart == 0) return true;
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view) {
+		if (mapping) CloseHandle(mapping);
+		this->close();
+		return false;
+	}
+
+	this->m_mapping = mapping;
+	this->m_data = static_cast<uint8_t const*>(view);
+	this->m_size = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void MappedFile::close() {
+	if (this->m_data) UnmapViewOfFile(this->m_data);
+	if (this->m_mapping) CloseHandle(this->m_mapping);
+	if (this->m_file) CloseHandle(this->m_file);
+	this->m_data = nullptr;
+	this->m_mapping = nullptr;
+	this->m_file = nullptr;
+	this->m_size = 0;
+	this->m_open = false;
+}
+
+#else
+
+bool MappedFile::open(std::filesystem::path const& filePath) {
+	this->close();
+
+	int fd = ::open(filePath.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		::close(fd);
+		return false;
+	}
+	this->m_open = true;
+	// Zero-length files cannot be mapped
+	if (info.st_size == 0) {
+		::close(fd);
+		return true;
+	}
+
+	void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	::close(fd);
+	if (view == MAP_FAILED) {
+		this->m_open = false;
+		return false;
+	}
+
+	this->m_data = static_cast<uint8_t const*>(view);
+	this->m_size = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::close() {
+	if (this->m_data)
+		munmap(const_cast<uint8_t*>(this->m_data), this->m_size);
+	this->m_data = nullptr;
+	this->m_size = 0;
+	this->m_open = false;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include "model.hpp"
+
+namespace dm {
+
+	// Read-only memory mapping of a whole file, unmapped on destruction
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile const&) = delete;
+		~MappedFile();
+
+		// Returns false if the file could not be opened or mapped.
+		// Empty files open successfully with empty data.
+		bool open(std::filesystem::path const& filePath);
+		void close();
+
+		bool isOpen() const { return this->m_open; }
+		ByteSpan data() const { return ByteSpan(this->m_data, this->m_size); }
+
+	private:
+		uint8_t const* m_data = nullptr;
+		size_t m_size = 0;
+		bool m_open = false;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <span>
+#include <string>
+
+// Geode-independent data model shared by the mod, the benchmarks and anything
+// else that wants to work with deaths without pulling in cocos or Geode.
+
+namespace dm {
+
+	// Read-only view over a received or stored chunk of bytes
+	using ByteSpan = std::span<uint8_t const>;
+
+	// Minimal stand-in for cocos' CCPoint
+	struct Vec2 {
+		float x = 0;
+		float y = 0;
+
+		Vec2 operator+(Vec2 const& other) const {
+			return { this->x + other.x, this->y + other.y };
+		}
+
+		Vec2 operator-(Vec2 const& other) const {
+			return { this->x - other.x, this->y - other.y };
+		}
+
+		bool operator==(Vec2 const& other) const = default;
+
+		float cross(Vec2 const& other) const {
+			return this->x * other.y - this->y * other.x;
+		}
+
+		float getLength() const {
+			return std::sqrt(this->x * this->x + this->y * this->y);
+		}
+
+		float getDistance(Vec2 const& other) const {
+			return (*this - other).getLength();
+		}
+	};
+
+	// Player state at the time of death, needed to draw a ghost cube
+	struct GhostPose {
+		float rotation = 0;
+		// Internal value of the enum IconType
+		int mode = 0;
+		bool isPlayer2 = false;
+		bool isMini = false;
+		bool isFlipped = false;
+		bool isMirrored = false;
+
+		uint8_t flagField() const {
+			return (this->isPlayer2 << 0) | (this->isMini << 1) |
+				(this->isFlipped << 2) | (this->isMirrored << 3);
+		}
+
+		void setFlags(uint8_t flagField) {
+			this->isPlayer2 = flagField & 1;
+			this->isMini = flagField & 2;
+			this->isFlipped = flagField & 4;
+			this->isMirrored = flagField & 8;
+		}
+	};
+
+	// Percentage of a death that was stored or sent without one, such as
+	// platformer deaths saved before their attempt time was kept
+	constexpr int noPercentage = -1;
+
+	// Holds only information about a death location that the server sends for
+	// regular gameplay, or that is stored locally
+	struct DeathEntry {
+		Vec2 pos;
+		int percentage = 0;
+		// Only present for local deaths recorded with ghost cubes enabled
+		std::optional<GhostPose> ghost;
+	};
+
+	// Holds all information about a death location that can be sent to the server
+	// Excludes info about the level, as it does not affect the death itself
+	struct DeathLocationOut {
+		Vec2 pos;
+		int percentage = 0;
+		/*
+		bool coin1 = false;
+		bool coin2 = false;
+		bool coin3 = false;
+		int itemdata = 0;
+		*/
+		bool practice = false;
+		std::time_t realTime = 0;
+
+		DeathLocationOut(Vec2 pos) : pos(pos), realTime(std::time(nullptr)) {}
+	};
+
+}
@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include "packedList.hpp"
+#include "bulkDecode.hpp"
+#include "simd.hpp"
+
+using namespace dm;
+
+namespace {
+
+	enum PackedFlags : uint8_t {
+		HasPercentage = 1 << 0
+	};
+
+	// Largest column of a block
+	size_t const maxColumnBytes = packedBlockSize * 32 / 8;
+	// Bytes past the end of a column the kernels may load
+	size_t const readAhead = 16;
+
+	uint32_t zigzag(int64_t value) {
+		return static_cast<uint32_t>((value << 1) ^ (value >> 63));
+	}
+
+	int32_t unzigzag(uint32_t value) {
+		return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1)));
+	}
+
+	void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back(static_cast<uint8_t>(value) | 0x80);
+			value >>= 7;
+		}
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	// Returns the bytes used, 0 if data ends first or the varint is too long
+	size_t readVarint(ByteSpan data, uint64_t* value) {
+		*value = 0;
+		for (size_t i = 0; i < data.size() && i < 10; i++) {
+			*value |= static_cast<uint64_t>(data[i] & 0x7f) << (i * 7);
+			if (!(data[i] & 0x80)) return i + 1;
+		}
+		return 0;
+	}
+
+	size_t columnBytes(size_t count, unsigned width) {
+		return (count * width + 7) / 8;
+	}
+
+	void pack(std::vector<uint8_t>& out, uint32_t const* values, size_t count,
+		unsigned width) {
+		uint64_t buffer = 0;
+		unsigned bits = 0;
+		for (size_t i = 0; i < count; i++) {
+			buffer |= static_cast<uint64_t>(values[i]) << bits;
+			bits += width;
+			while (bits >= 8) {
+				out.push_back(static_cast<uint8_t>(buffer));
+				buffer >>= 8;
+				bits -= 8;
+			}
+		}
+		if (bits) out.push_back(static_cast<uint8_t>(buffer));
+	}
+
+	// Adds up count deltas of Width bits from data and writes the running
+	// sums, starting from *sum, to out, scaled by step if out holds floats.
+	// data must be readable for 8 bytes past the last value. A constant
+	// width lets the compiler turn the shifts and masks into immediates, and
+	// doing it all in one pass keeps the values in registers.
+	template <unsigned Width, bool Zigzag, typename T>
+	void accumulateColumn(uint8_t const* data, size_t count, int32_t* sum,
+		float step, T* out) {
+
+		uint64_t const mask = (static_cast<uint64_t>(1) << Width) - 1;
+		int32_t value = *sum;
+		auto add = [&](uint8_t const* at, unsigned shift, size_t i) {
+			uint64_t word;
+			std::memcpy(&word, at, sizeof(word));
+			uint32_t const delta = static_cast<uint32_t>((word >> shift) & mask);
+			value += Zigzag ? unzigzag(delta) : static_cast<int32_t>(delta);
+			if constexpr (std::is_same_v<T, float>) out[i] = static_cast<float>(value) * step;
+			else out[i] = value;
+		};
+
+		// Every 8 values end on a byte boundary, so all offsets within a
+		// group are constants
+		size_t const groups = count / 8;
+		for (size_t group = 0; group < groups; group++) {
+			uint8_t const* base = data + group * Width;
+			for (unsigned i = 0; i < 8; i++)
+				add(base + i * Width / 8, i * Width % 8, group * 8 + i);
+		}
+		for (size_t i = groups * 8; i < count; i++)
+			add(data + i * Width / 8, i * Width % 8, i);
+		*sum = value;
+	}
+
+	template <typename T>
+	using AccumulateFn = void (*)(uint8_t const*, size_t, int32_t*, float, T*);
+
+	template <bool Zigzag, typename T, size_t... Widths>
+	constexpr auto makeAccumulateTable(std::index_sequence<Widths...>) {
+		return std::array<AccumulateFn<T>, sizeof...(Widths)>{
+			&accumulateColumn<Widths, Zigzag, T>...
+		};
+	}
+
+	// x only grows, y and percentages are zigzag encoded
+	constexpr auto accumulateX = makeAccumulateTable<false, float>(
+		std::make_index_sequence<33>());
+	constexpr auto accumulateY = makeAccumulateTable<true, float>(
+		std::make_index_sequence<33>());
+	constexpr auto accumulatePercentage = makeAccumulateTable<true, int>(
+		std::make_index_sequence<33>());
+
+#ifdef DM_X86
+
+	// Widths up to this fit 4 values into 16 bytes at any bit offset
+	unsigned const maxVectorWidth = 24;
+
+	// Byte shuffle and shift that move the 8 values of a group of Width
+	// bits into 32 bit elements, the low lane loaded from the start of the
+	// group and the high lane from the byte holding value 4
+	struct UnpackPattern {
+		uint8_t shuffle[32];
+		uint32_t shift[8];
+	};
+
+	constexpr UnpackPattern makeUnpackPattern(unsigned width) {
+		UnpackPattern pattern{};
+		for (unsigned i = 0; i < 8; i++) {
+			unsigned const lane = i / 4;
+			unsigned const bit = i * width - lane * (4 * width / 8 * 8);
+			for (unsigned b = 0; b < 4; b++) {
+				pattern.shuffle[lane * 16 + i % 4 * 4 + b] =
+					static_cast<uint8_t>(bit / 8 + b);
+			}
+			pattern.shift[i] = bit % 8;
+		}
+		return pattern;
+	}
+
+	template <size_t... Widths>
+	constexpr auto makeUnpackPatterns(std::index_sequence<Widths...>) {
+		return std::array<UnpackPattern, sizeof...(Widths)>{
+			makeUnpackPattern(Widths)...
+		};
+	}
+
+	constexpr auto unpackPatterns = makeUnpackPatterns(
+		std::make_index_sequence<maxVectorWidth + 1>());
+
+	// Same as accumulateColumn for whole groups of 8 values, returns how many
+	// values it handled.
+	template <bool Zigzag, typename T>
+	DM_TARGET_AVX2 size_t accumulateColumnAVX2(uint8_t const* data,
+		size_t count, unsigned width, int32_t* sum, float step, T* out) {
+
+		if (width > maxVectorWidth) return 0;
+		auto const& pattern = unpackPatterns[width];
+		__m256i const shuffle = _mm256_loadu_si256(
+			reinterpret_cast<__m256i const*>(pattern.shuffle));
+		__m256i const shift = _mm256_loadu_si256(
+			reinterpret_cast<__m256i const*>(pattern.shift));
+		__m256i const mask = _mm256_set1_epi32(
+			static_cast<int32_t>((static_cast<uint64_t>(1) << width) - 1));
+		__m256i const one = _mm256_set1_epi32(1);
+		__m256i const highLane = _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1);
+		__m256i const lastOfLow = _mm256_set1_epi32(3);
+		__m256i const last = _mm256_set1_epi32(7);
+		__m256 const scale = _mm256_set1_ps(step);
+		size_t const highOffset = 4 * width / 8;
+
+		__m256i running = _mm256_set1_epi32(*sum);
+		size_t const groups = count / 8;
+		for (size_t group = 0; group < groups; group++) {
+			uint8_t const* base = data + group * width;
+			__m256i deltas = _mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(base))),
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(base + highOffset)), 1);
+			deltas = _mm256_and_si256(_mm256_srlv_epi32(
+				_mm256_shuffle_epi8(deltas, shuffle), shift), mask);
+			if constexpr (Zigzag) {
+				deltas = _mm256_xor_si256(_mm256_srli_epi32(deltas, 1),
+					_mm256_sub_epi32(_mm256_setzero_si256(),
+						_mm256_and_si256(deltas, one)));
+			}
+
+			// Running sums within each lane, then across them
+			deltas = _mm256_add_epi32(deltas, _mm256_slli_si256(deltas, 4));
+			deltas = _mm256_add_epi32(deltas, _mm256_slli_si256(deltas, 8));
+			deltas = _mm256_add_epi32(deltas, _mm256_and_si256(highLane,
+				_mm256_permutevar8x32_epi32(deltas, lastOfLow)));
+			__m256i const values = _mm256_add_epi32(deltas, running);
+			running = _mm256_permutevar8x32_epi32(values, last);
+
+			if constexpr (std::is_same_v<T, float>) {
+				_mm256_storeu_ps(out + group * 8,
+					_mm256_mul_ps(_mm256_cvtepi32_ps(values), scale));
+			}
+			else {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + group * 8),
+					values);
+			}
+		}
+		*sum = _mm_cvtsi128_si32(_mm256_castsi256_si128(running));
+		return groups * 8;
+	}
+
+#endif
+
+	// Sums up a column with the fastest kernel available
+	template <bool Zigzag, typename T>
+	void accumulate(std::array<AccumulateFn<T>, 33> const& table,
+		uint8_t const* data, size_t count, unsigned width, int32_t* sum,
+		float step, T* out) {
+
+		size_t done = 0;
+#ifdef DM_X86
+		if (getDecodeKernel() == DecodeKernel::AVX2)
+			done = accumulateColumnAVX2<Zigzag>(data, count, width, sum, step, out);
+#endif
+		table[width](data + done * width / 8, count - done, sum, step, out + done);
+	}
+
+	// Loads may only run past a column if readable bytes are left until
+	// end, the end of the data goes through a zero padded copy instead
+	uint8_t const* readableColumn(uint8_t const* data, uint8_t const* end,
+		size_t bytes, uint8_t* padded) {
+		if (static_cast<size_t>(end - data) >= bytes + readAhead) return data;
+		std::memcpy(padded, data, bytes);
+		std::memset(padded + bytes, 0, maxColumnBytes + readAhead - bytes);
+		return padded;
+	}
+
+	unsigned widthOf(uint32_t const* values, size_t count) {
+		uint32_t combined = 0;
+		for (size_t i = 0; i < count; i++) combined |= values[i];
+		return std::bit_width(combined);
+	}
+
+}
+
+std::vector<uint8_t> dm::encodePackedList(DeathStore const& deaths,
+	bool hasPercentage, uint32_t scale) {
+
+	std::vector<uint8_t> out;
+	out.reserve(16 + deaths.size() * 3);
+	out.push_back(packedListVersion);
+	out.push_back(hasPercentage ? HasPercentage : 0);
+	writeVarint(out, scale);
+	writeVarint(out, deaths.size());
+
+	auto quantize = [scale](float value) {
+		return std::llround(static_cast<double>(value) * scale);
+	};
+	int64_t x = deaths.empty() ? 0 : quantize(deaths.x(0));
+	int64_t y = 0;
+	int64_t percentage = 0;
+	writeVarint(out, zigzag(x));
+
+	uint32_t dx[packedBlockSize];
+	uint32_t dy[packedBlockSize];
+	uint32_t dp[packedBlockSize];
+	for (size_t start = 0; start < deaths.size(); start += packedBlockSize) {
+		size_t const count = std::min(packedBlockSize, deaths.size() - start);
+		for (size_t i = 0; i < count; i++) {
+			int64_t const qx = quantize(deaths.x(start + i));
+			int64_t const qy = quantize(deaths.y(start + i));
+			int64_t const p = deaths.percentage(start + i);
+			dx[i] = static_cast<uint32_t>(qx - x);
+			dy[i] = zigzag(qy - y);
+			dp[i] = zigzag(p - percentage);
+			x = qx;
+			y = qy;
+			percentage = p;
+		}
+
+		unsigned const widthX = widthOf(dx, count);
+		unsigned const widthY = widthOf(dy, count);
+		unsigned const widthP = widthOf(dp, count);
+		out.push_back(static_cast<uint8_t>(widthX));
+		out.push_back(static_cast<uint8_t>(widthY));
+		if (hasPercentage) out.push_back(static_cast<uint8_t>(widthP));
+		pack(out, dx, count, widthX);
+		pack(out, dy, count, widthY);
+		if (hasPercentage) pack(out, dp, count, widthP);
+	}
+	return out;
+}
+
+PackedListReader::PackedListReader(DeathStore* target) {
+	this->m_target = target;
+}
+
+size_t PackedListReader::read(ByteSpan data) {
+	size_t consumed = 0;
+	while (true) {
+		size_t used = 0;
+		if (this->m_state == State::Header)
+			used = this->readHeader(data.subspan(consumed));
+		else if (this->m_state == State::Blocks)
+			used = this->readBlock(data.subspan(consumed));
+		if (!used) return consumed;
+		consumed += used;
+	}
+}
+
+size_t PackedListReader::readHeader(ByteSpan data) {
+	if (data.empty()) return 0;
+	size_t offset = 1;
+	uint64_t scale, count, origin;
+
+	size_t used = readVarint(data.subspan(offset), &scale);
+	if (!used) return 0;
+	offset += used;
+	used = readVarint(data.subspan(offset), &count);
+	if (!used) return 0;
+	offset += used;
+	used = readVarint(data.subspan(offset), &origin);
+	if (!used) return 0;
+	offset += used;
+
+	// Every block takes at least one width byte per column, so a count that
+	// would not fit into the body can only come from a corrupt header
+	bool const hasPercentage = data[0] & HasPercentage;
+	uint64_t const blocks = count / packedBlockSize +
+		(count % packedBlockSize != 0);
+	bool const fits = this->m_expected &&
+		blocks <= this->m_expected / (hasPercentage ? 3 : 2);
+
+	if (scale == 0 || origin > UINT32_MAX || static_cast<size_t>(count) != count ||
+		(this->m_expected && !fits)) {
+		this->m_state = State::Failed;
+		return 0;
+	}
+
+	this->m_hasPercentage = hasPercentage;
+	this->m_step = 1.0f / static_cast<float>(scale);
+	this->m_count = count;
+	this->m_remaining = count;
+	this->m_x = unzigzag(static_cast<uint32_t>(origin));
+	this->m_state = count ? State::Blocks : State::Done;
+	// Without a known size, space grows with every decoded block instead
+	if (fits) this->m_target->reserve(this->m_target->size() + count);
+	return offset;
+}
+
+size_t PackedListReader::readBlock(ByteSpan data) {
+	size_t const count = std::min(packedBlockSize, this->m_remaining);
+	size_t const columns = this->m_hasPercentage ? 3 : 2;
+	if (data.size() < columns) return 0;
+
+	unsigned widths[3] = { 0, 0, 0 };
+	size_t size = columns;
+	for (size_t c = 0; c < columns; c++) {
+		widths[c] = data[c];
+		if (widths[c] > 32) {
+			this->m_state = State::Failed;
+			return 0;
+		}
+		size += columnBytes(count, widths[c]);
+	}
+	if (data.size() < size) return 0;
+
+	auto out = this->m_target->extend(count);
+	uint8_t const* column = data.data() + columns;
+	uint8_t const* end = data.data() + data.size();
+	uint8_t padded[maxColumnBytes + readAhead];
+	size_t bytes = columnBytes(count, widths[0]);
+	accumulate<false>(accumulateX, readableColumn(column, end, bytes, padded), count,
+		widths[0], &this->m_x, this->m_step, out.x);
+	column += bytes;
+	bytes = columnBytes(count, widths[1]);
+	accumulate<true>(accumulateY, readableColumn(column, end, bytes, padded), count,
+		widths[1], &this->m_y, this->m_step, out.y);
+	column += bytes;
+	if (this->m_hasPercentage) {
+		bytes = columnBytes(count, widths[2]);
+		accumulate<true>(accumulatePercentage, readableColumn(column, end, bytes, padded),
+			count, widths[2], &this->m_percentage, 0.0f, out.percentage);
+	}
+
+	this->m_remaining -= count;
+	if (!this->m_remaining) this->m_state = State::Done;
+	return size;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "model.hpp"
+#include "deathStore.hpp"
+
+// Version 2 of binary /list responses. Positions are quantized to a grid,
+// stored as differences to the previous death in x order and bit-packed in
+// blocks, see "Binary transmission" in docs/doc.md.
+
+namespace dm {
+
+	uint8_t const packedListVersion = 2;
+	// Deaths per block, all values of a column in a block share a bit width
+	size_t const packedBlockSize = 128;
+
+	// Encodes deaths sorted by x with scale grid steps per unit
+	std::vector<uint8_t> encodePackedList(DeathStore const& deaths,
+		bool hasPercentage, uint32_t scale);
+
+	// Incremental decoder for the body following the versioning byte.
+	// Only whole blocks are decoded, the caller keeps the rest of the data
+	// around until more of it arrives.
+	class PackedListReader {
+	public:
+		enum class State {
+			Header,
+			Blocks,
+			Done,
+			Failed
+		};
+
+		explicit PackedListReader(DeathStore* target);
+
+		// Bounds the death count a header may announce by the size of the
+		// body after the versioning byte. Space for the deaths is only
+		// reserved up front once the count is known to fit.
+		void setExpectedSize(size_t bytes) { this->m_expected = bytes; }
+		// Decodes as much of data as possible and returns the number of
+		// bytes used up
+		size_t read(ByteSpan data);
+
+		State getState() const { return this->m_state; }
+		bool hasPercentage() const { return this->m_hasPercentage; }
+		// Deaths announced by the header
+		size_t getCount() const { return this->m_count; }
+
+	private:
+		DeathStore* m_target;
+		State m_state = State::Header;
+		bool m_hasPercentage = false;
+		float m_step = 1;
+		size_t m_count = 0;
+		size_t m_remaining = 0;
+		// 0 if unknown
+		size_t m_expected = 0;
+		int32_t m_x = 0;
+		int32_t m_y = 0;
+		int32_t m_percentage = 0;
+
+		size_t readHeader(ByteSpan data);
+		size_t readBlock(ByteSpan data);
+	};
+
+}
@@ -0,0 +1,78 @@
+#include <cmath>
+#include "pager.hpp"
+
+using namespace dm;
+
+DeathPager::DeathPager(float pageWidth, int ahead, int behind) {
+	this->m_pageWidth = pageWidth;
+	this->m_ahead = ahead;
+	this->m_behind = behind;
+}
+
+int DeathPager::pageOf(float x) const {
+	return static_cast<int>(std::floor(x / this->m_pageWidth));
+}
+
+float DeathPager::pageBegin(int page) const {
+	return page * this->m_pageWidth;
+}
+
+float DeathPager::pageEnd(int page) const {
+	return (page + 1) * this->m_pageWidth;
+}
+
+std::optional<int> DeathPager::nextMissing(float x) const {
+	int const current = this->pageOf(x);
+	auto missing = [this](int page) {
+		return !this->m_pages.contains(page);
+	};
+
+	for (int page = current; page <= current + this->m_ahead; page++)
+		if (missing(page)) return page;
+	for (int page = current - 1; page >= current - this->m_behind; page--)
+		if (missing(page)) return page;
+	return std::nullopt;
+}
+
+void DeathPager::setRequested(int page) {
+	this->m_pages[page] = PageState::Requested;
+}
+
+void DeathPager::setLoaded(int page) {
+	this->m_pages[page] = PageState::Loaded;
+}
+
+void DeathPager::setMissing(int page) {
+	auto it = this->m_pages.find(page);
+	if (it != this->m_pages.end() && it->second == PageState::Requested)
+		this->m_pages.erase(it);
+}
+
+void DeathPager::pin(int page) {
+	this->m_pinned.insert(page);
+}
+
+bool DeathPager::isLoaded(int page) const {
+	auto it = this->m_pages.find(page);
+	return it != this->m_pages.end() && it->second == PageState::Loaded;
+}
+
+std::vector<int> DeathPager::takeEvictable(float x) {
+	// One page of slack, so moving back and forth across a page boundary
+	// does not fetch the same page over and over
+	int const current = this->pageOf(x);
+	int const first = current - this->m_behind - 1;
+	int const last = current + this->m_ahead + 1;
+
+	std::vector<int> evicted;
+	for (auto it = this->m_pages.begin(); it != this->m_pages.end();) {
+		bool const inRange = it->first >= first && it->first <= last;
+		if (!inRange && it->second == PageState::Loaded &&
+			!this->m_pinned.contains(it->first)) {
+			evicted.push_back(it->first);
+			it = this->m_pages.erase(it);
+		}
+		else ++it;
+	}
+	return evicted;
+}
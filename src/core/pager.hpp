@@ -0,0 +1,49 @@
+#pragma once
+#include <map>
+#include <optional>
+#include <set>
+#include <vector>
+
+namespace dm {
+
+	// Decides which pages of a level's deaths to hold while the player moves
+	// through it, a page being a fixed-width range of x. The page the player
+	// is in is loaded first, then the ones ahead of it, then the ones behind.
+	// Pages the player has moved away from are dropped again unless pinned,
+	// e.g. because they hold deaths of the current session.
+	class DeathPager {
+	public:
+		explicit DeathPager(float pageWidth = 2048, int ahead = 1, int behind = 1);
+
+		int pageOf(float x) const;
+		// Deaths in a page have pageBegin <= x < pageEnd
+		float pageBegin(int page) const;
+		float pageEnd(int page) const;
+
+		// Page around x to fetch next, nothing if all are loaded or requested
+		std::optional<int> nextMissing(float x) const;
+		void setRequested(int page);
+		void setLoaded(int page);
+		// Allows a page to be requested again, e.g. after a failed request
+		void setMissing(int page);
+		void pin(int page);
+		bool isLoaded(int page) const;
+
+		// Unpinned loaded pages too far from x, they count as missing again
+		std::vector<int> takeEvictable(float x);
+
+	private:
+		enum class PageState {
+			Requested,
+			Loaded
+		};
+
+		float m_pageWidth;
+		int m_ahead;
+		int m_behind;
+		// Pages without an entry are missing
+		std::map<int, PageState> m_pages;
+		std::set<int> m_pinned;
+	};
+
+}
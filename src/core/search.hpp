@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+namespace dm {
+
+	// Binary searches over sorted keys without a branch per step: the loop
+	// runs a fixed number of times for a given size and each step adds the
+	// result of its comparison, so mispredictions do not stall it. Written as
+	// a ternary, compilers turn it back into a branch. Without speculation
+	// nothing loads ahead either, so both keys the next step may probe are
+	// prefetched.
+
+	inline void prefetchKey(float const* key) {
+#if defined(__GNUC__) || defined(__clang__)
+		__builtin_prefetch(key);
+#else
+		(void)key;
+#endif
+	}
+
+	// Index of the first key not less than x, or keys.size()
+	inline size_t lowerBoundBranchless(std::span<float const> keys, float x) {
+		if (keys.empty()) return 0;
+		float const* base = keys.data();
+		size_t count = keys.size();
+		while (count > 1) {
+			size_t const half = count / 2;
+			prefetchKey(base + half / 2);
+			prefetchKey(base + half + half / 2);
+			base += (base[half - 1] < x) * half;
+			count -= half;
+		}
+		return (base - keys.data()) + (*base < x);
+	}
+
+	// Index of the first key greater than x, or keys.size()
+	inline size_t upperBoundBranchless(std::span<float const> keys, float x) {
+		if (keys.empty()) return 0;
+		float const* base = keys.data();
+		size_t count = keys.size();
+		while (count > 1) {
+			size_t const half = count / 2;
+			prefetchKey(base + half / 2);
+			prefetchKey(base + half + half / 2);
+			base += (base[half - 1] <= x) * half;
+			count -= half;
+		}
+		return (base - keys.data()) + (*base <= x);
+	}
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Intrinsics and per-function target attributes for the kernels that are
+// picked at runtime, see DecodeKernel in bulkDecode.hpp. DM_X86 is only
+// defined where they are available.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DM_TARGET_SSE2
+#define DM_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define DM_TARGET_SSE2 __attribute__((target("sse2")))
+#define DM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
@@ -0,0 +1,79 @@
+#include <cmath>
+#include "sketch.hpp"
+
+using namespace dm;
+
+QuantileSketch::QuantileSketch(double relativeAccuracy) {
+	this->m_gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+	this->m_logGamma = std::log(this->m_gamma);
+}
+
+void QuantileSketch::clear() {
+	this->m_zeroCount = 0;
+	this->m_counts.clear();
+	this->m_offset = 0;
+	this->m_count = 0;
+}
+
+// Bucket key covers values in (gamma^(key - 1), gamma^key]
+int QuantileSketch::key(double value) const {
+	return static_cast<int>(std::ceil(std::log(value) / this->m_logGamma));
+}
+
+double QuantileSketch::value(int key) const {
+	// Midpoint in relative terms, off by at most relativeAccuracy
+	return 2 * std::pow(this->m_gamma, key) / (this->m_gamma + 1);
+}
+
+double QuantileSketch::bucketValue(double value) const {
+	if (!(value > minValue)) return 0;
+	return this->value(this->key(value));
+}
+
+void QuantileSketch::add(double value) {
+	this->m_count++;
+	if (!(value > minValue)) {
+		this->m_zeroCount++;
+		return;
+	}
+
+	int const key = this->key(value);
+	if (this->m_counts.empty()) this->m_offset = key;
+	if (key < this->m_offset) {
+		this->m_counts.insert(this->m_counts.begin(), this->m_offset - key, 0);
+		this->m_offset = key;
+	}
+	size_t const index = key - this->m_offset;
+	if (index >= this->m_counts.size()) this->m_counts.resize(index + 1, 0);
+	this->m_counts[index]++;
+}
+
+bool QuantileSketch::remove(double value) {
+	if (!(value > minValue)) {
+		if (!this->m_zeroCount) return false;
+		this->m_zeroCount--;
+		this->m_count--;
+		return true;
+	}
+
+	int const key = this->key(value);
+	if (key < this->m_offset) return false;
+	size_t const index = key - this->m_offset;
+	if (index >= this->m_counts.size() || !this->m_counts[index]) return false;
+	this->m_counts[index]--;
+	this->m_count--;
+	return true;
+}
+
+double QuantileSketch::quantile(double q) const {
+	if (!this->m_count) return 0;
+
+	uint64_t const rank = static_cast<uint64_t>(q * (this->m_count - 1));
+	uint64_t seen = this->m_zeroCount;
+	if (seen > rank) return 0;
+	for (size_t i = 0; i < this->m_counts.size(); i++) {
+		seen += this->m_counts[i];
+		if (seen > rank) return this->value(static_cast<int>(i) + this->m_offset);
+	}
+	return this->value(static_cast<int>(this->m_counts.size()) - 1 + this->m_offset);
+}
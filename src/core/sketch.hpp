@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace dm {
+
+	// Streaming quantile sketch with relative accuracy (DDSketch). Values
+	// are counted in buckets whose bounds grow geometrically, so any quantile
+	// is known to within relativeAccuracy of its value without keeping or
+	// sorting the values themselves, and adding or removing one is O(1).
+	class QuantileSketch {
+	public:
+		explicit QuantileSketch(double relativeAccuracy = 0.005);
+
+		void clear();
+		void add(double value);
+		// Returns false if no value was counted in value's bucket
+		bool remove(double value);
+
+		uint64_t count() const { return this->m_count; }
+		// Value below which a fraction q of the values are, 0 if empty
+		double quantile(double q) const;
+		// What value is counted as, i.e. the value of its bucket
+		double bucketValue(double value) const;
+
+		// Calls fn(value, count) for every non-empty bucket in ascending order
+		template <typename F>
+		void forEachBucket(F&& fn) const {
+			if (this->m_zeroCount) fn(0.0, this->m_zeroCount);
+			for (size_t i = 0; i < this->m_counts.size(); i++)
+				if (this->m_counts[i])
+					fn(this->value(static_cast<int>(i) + this->m_offset), this->m_counts[i]);
+		}
+
+	private:
+		double m_gamma;
+		double m_logGamma;
+		// Values this small or smaller, including negative ones, count as 0
+		static constexpr double minValue = 1e-6;
+		uint32_t m_zeroCount = 0;
+		// Counts of buckets m_offset onwards
+		std::vector<uint32_t> m_counts;
+		int m_offset = 0;
+		uint64_t m_count = 0;
+
+		int key(double value) const;
+		double value(int key) const;
+	};
+
+}
@@ -0,0 +1,40 @@
+#include <unordered_map>
+#include "spam.hpp"
+
+#define translate( X ) static_cast<int>(X / 30)
+
+using namespace dm;
+
+void dm::purgeSpam(std::vector<DeathLocationOut>& deaths) {
+	size_t total = deaths.size();
+
+	if (total < 10) return;
+
+	std::time_t timeDiff = deaths.back().realTime - deaths.front().realTime;
+	// Limit to 1 death per 1.5 seconds
+	if (timeDiff * 2 < static_cast<long long>(total) * 3) {
+		deaths.clear();
+		return;
+	}
+
+	if (total < 20) return;
+
+	std::unordered_map<int, uint32_t> xFrequency;
+	for (auto i = deaths.begin(); i < deaths.end(); i++) {
+		int translatedX = translate ( i->pos.x );
+		if (xFrequency.contains(translatedX)) xFrequency[translatedX] = 0;
+		xFrequency[translatedX]++;
+	}
+
+	uint32_t max = 0;
+	for (auto& [x, count] : xFrequency) {
+		if (count > max) max = count;
+	}
+
+	if (max * max / 2 < total) return;
+
+	std::erase_if(deaths, [&xFrequency, max](auto& d){
+		int translatedX = translate ( d.pos.x );
+		return static_cast<float>(xFrequency[translatedX]) / max > .8;
+	});
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <vector>
+#include "model.hpp"
+
+namespace dm {
+
+	// Removes deaths that look like intentional spam before submitting
+	void purgeSpam(std::vector<DeathLocationOut>& deaths);
+
+}
@@ -5,11 +5,19 @@
 #include <Geode/ui/BasedButtonSprite.hpp>
 #include <vector>
 #include "shared.hpp"
-#include "cluster.hpp"
+#include "core/cluster.hpp"
 
 using namespace dm;
 constexpr auto BUTTON_ID = "load-button"_spr;
 
+// Deaths of the level last analysed, so opening it again only downloads
+// what was submitted in the meantime
+static struct {
+	int levelId = 0;
+	uint64_t cursor = 0;
+	AnalysisStore deaths;
+} analysisCache;
+
 #include <Geode/modify/LevelEditorLayer.hpp>
 class $modify(DMEditorLayer, LevelEditorLayer) {
 
@@ -19,6 +27,9 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 		CCNode* m_stackNode = nullptr;
 		CCNode* m_dmNode = nullptr;
 		CCNodeRGBA* m_darkNode = nullptr;
+		// Drawn instead of markers and stacks for levels with many deaths
+		CCNode* m_heatmapNode = nullptr;
+		bool m_heatmap = false;
 
 		vector<DeathLocation> m_deaths;
 
@@ -56,7 +67,13 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 			menuEl->setEnabled(false);
 		}
 
-		// Parse result JSON and add all as DeathLocationMin instances to playingLevel.deaths
+		if (analysisCache.levelId != levelId) {
+			analysisCache.levelId = levelId;
+			analysisCache.cursor = 0;
+			analysisCache.deaths.clear();
+		}
+
+		// Parse result and add all as DeathLocation instances to m_deaths
 		m_fields->m_listener.bind(
 			[this](web::WebTask::Event* const e) {
 				auto res = e->getValue();
@@ -80,7 +97,21 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 					}
 					else {
 						log::debug("Received death list.");
-						parseBinDeathList(res, &this->m_fields->m_deaths);
+						AnalysisStore fetched;
+						if (parseBinDeathList(res, &fetched)) {
+							// Anything but the deaths since the cursor replaces the cache
+							auto since = cursorHeader(res, "X-Death-Since");
+							if (!since || *since != analysisCache.cursor)
+								analysisCache.deaths.clear();
+							analysisCache.deaths.append(fetched);
+							analysisCache.cursor = cursorHeader(res, "X-Death-Cursor")
+								.value_or(0);
+
+							auto const& deaths = analysisCache.deaths;
+							this->m_fields->m_deaths.reserve(deaths.size());
+							for (size_t i = 0; i < deaths.size(); i++)
+								this->m_fields->m_deaths.emplace_back(deaths, i);
+						}
 						log::debug("Finished parsing.");
 						analyzeData();
 						startUI();
@@ -109,7 +140,8 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 		web::WebRequest req = web::WebRequest();
 
 		req.param("levelid", levelId);
-		req.param("response", "bin");
+		req.param("response", "bin2");
+		if (analysisCache.cursor) req.param("since", analysisCache.cursor);
 		req.userAgent(HTTP_AGENT);
 		req.timeout(HTTP_TIMEOUT);
 
@@ -139,6 +171,11 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 
 			this->m_fields->m_darkNode->removeFromParent();
 
+			if (this->m_fields->m_heatmapNode) {
+				this->m_fields->m_heatmapNode->removeFromParent();
+				this->m_fields->m_heatmapNode = nullptr;
+			}
+
 			for (auto& deathLoc : this->m_fields->m_deaths)
 				deathLoc.node = nullptr;
 
@@ -149,19 +186,31 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 
 	void updateStacks(float maxDistance) {
 
-		if (!Mod::get()->getSettingValue<bool>("stacks-in-editor")) return;
+		if (!settings.stacksInEditor || this->m_fields->m_heatmap) return;
 
-		auto deathStacks = new vector<DeathLocationStack>();
+		auto& deaths = this->m_fields->m_deaths;
+		vector<Vec2> positions;
+		positions.reserve(deaths.size());
+		for (auto& deathLoc : deaths) {
+			positions.push_back(toVec2(deathLoc.pos));
+			deathLoc.clustered = false;
+		}
 
-		identifyClusters(&this->m_fields->m_deaths, maxDistance, deathStacks);
+		log::debug("Clustering {} entries with maximum distance {}",
+			positions.size(), maxDistance);
+		vector<DeathLocationStack> deathStacks;
+		identifyClusters(positions, maxDistance, &deathStacks);
+		log::debug("Finished clustering into {} stacks.", deathStacks.size());
 
 		this->m_fields->m_stackNode->removeAllChildrenWithCleanup(true);
-		for (auto stack = deathStacks->begin(); stack < deathStacks->end(); stack++) {
+		for (auto stack = deathStacks.begin(); stack < deathStacks.end(); stack++) {
+			for (auto index : stack->deaths) deaths[index].clustered = true;
+
 			auto sprite = CCSprite::create("marker-group.png"_spr);
 			sprite->setID("marker-stack"_spr);
 			sprite->setScale(max(stack->circle.r * 2.125f, maxDistance / 2) / sprite->getContentWidth());
 			sprite->setZOrder(1);
-			sprite->setPosition(stack->circle.c);
+			sprite->setPosition(toCCPoint(stack->circle.c));
 			sprite->setAnchorPoint({ 0.5f, 0.5f });
 
 			auto countText = CCLabelBMFont::create(
@@ -182,13 +231,13 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 
 	void analyzeData() {
 
-		auto completed = set<std::string>();
+		auto completed = set<uint32_t>();
 
 		if (!this->m_level->isPlatformer()) {
 			erase_if(this->m_fields->m_deaths,
 				[&completed](const DeathLocation& death) {
 					if (death.percentage != 101) return false;
-					completed.insert(death.userIdent);
+					completed.insert(death.player);
 					return true;
 				}
 			);
@@ -199,7 +248,7 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 				this->m_fields->m_deaths.begin(),
 				this->m_fields->m_deaths.end(),
 				[](const DeathLocation& a, const DeathLocation& b) {
-					return a.userIdent.compare(b.userIdent) < 0;
+					return a.player < b.player;
 				}
 			);
 		}
@@ -245,7 +294,10 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 		this->m_fields->m_stackNode->setID("stacks"_spr);
 		this->m_fields->m_stackNode->setZOrder(-2);
 
-		for (auto& deathLoc : this->m_fields->m_deaths) {
+		auto const& deaths = this->m_fields->m_deaths;
+		this->m_fields->m_heatmap = prefersHeatmap(deaths.size());
+		if (this->m_fields->m_heatmap) this->buildHeatmap();
+		else for (auto& deathLoc : this->m_fields->m_deaths) {
 			auto node = deathLoc.createNode();
 			node->setZOrder(0);
 			this->m_fields->m_dmNode->addChild(node);
@@ -263,7 +315,7 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 		this->m_fields->m_darkNode->setPosition(CCPoint(0, 0));
 		this->m_fields->m_darkNode->setAnchorPoint(CCPoint(0, 0));
 		this->m_fields->m_darkNode->setColor({0, 0, 0});
-		this->m_fields->m_darkNode->setOpacity(Mod::get()->getSettingValue<int64_t>("darken-editor"));
+		this->m_fields->m_darkNode->setOpacity(settings.darkenEditor);
 		this->m_fields->m_darkNode->setZOrder(-4);
 
 		this->m_editorUI->addChild(this->m_fields->m_darkNode);
@@ -276,15 +328,42 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 
 	}
 
+	void buildHeatmap() {
+
+		std::vector<float> xs, ys;
+		xs.reserve(this->m_fields->m_deaths.size());
+		ys.reserve(this->m_fields->m_deaths.size());
+		for (auto const& deathLoc : this->m_fields->m_deaths) {
+			xs.push_back(deathLoc.pos.x);
+			ys.push_back(deathLoc.pos.y);
+		}
+
+		WeakRef<DMEditorLayer> self = this;
+		buildHeatmapNode(std::move(xs), std::move(ys), [self](CCNode* node) {
+			// Editor may have been left or markers turned off in the meantime
+			auto layer = self.lock();
+			if (!layer || !layer->m_fields->m_enabled) return;
+			if (layer->m_fields->m_heatmapNode) return;
+
+			node->setZOrder(-3);
+			layer->m_fields->m_heatmapNode = node;
+			layer->m_editorUI->addChild(node);
+		});
+
+	}
+
 	void updateMarkers(float) {
+		if (auto heatmap = this->m_fields->m_heatmapNode) {
+			heatmap->setPosition(this->m_objectLayer->getPosition());
+			heatmap->setScale(this->m_objectLayer->getScale());
+		}
 		this->m_fields->m_dmNode->setPosition(this->m_objectLayer->getPosition());
 		this->m_fields->m_dmNode->setScale(this->m_objectLayer->getScale());
 		this->m_fields->m_stackNode->setPosition(this->m_objectLayer->getPosition());
 		this->m_fields->m_stackNode->setScale(this->m_objectLayer->getScale());
 
 		// Counters UI zoom, keeps markers at constant size relative to screen
-		float inverseScale = Mod::get()->getSettingValue<float>("marker-scale") /
-			this->m_objectLayer->getScale();
+		float inverseScale = settings.markerScale / this->m_objectLayer->getScale();
 
 		if (this->m_fields->m_lastZoom != this->m_objectLayer->getScale()) {
 			updateStacks(20 / this->m_objectLayer->getScale());
@@ -298,7 +377,8 @@ class $modify(DMEditorLayer, LevelEditorLayer) {
 		}
 		
 		for (auto& deathLoc : this->m_fields->m_deaths) {
-			deathLoc.updateNode();
+			// No nodes are created when drawing a heatmap
+			if (deathLoc.node) deathLoc.updateNode();
 		}
 	}
 
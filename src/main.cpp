@@ -2,11 +2,17 @@
 #include <Geode/utils/web.hpp>
 #include <Geode/ui/GeodeUI.hpp>
 #include <Geode/platform/platform.hpp>
+#include <algorithm>
+#include <deque>
+#include <memory>
 #include <vector>
 #include <string>
+#include <thread>
 #include <stdlib.h>
 #include "shared.hpp"
 #include "submitter.hpp"
+#include "core/pager.hpp"
+#include "core/spam.hpp"
 #include "lib/sha1.hpp"
 
 using namespace geode::prelude;
@@ -30,27 +36,114 @@ enum DMDrawScope {
 	GLOBAL
 };
 
+// Seconds between page requests, the server allows 2 requests per 8 seconds
+constexpr float PAGE_INTERVAL = 4;
+// Longest wait before a failed page is requested again
+constexpr float PAGE_MAX_BACKOFF = 64;
+
+// Local deaths being loaded by runLocalIO, shared between a layer and its
+// loader. Only the main thread touches abandoned and takes over journal.
+struct LocalLoad {
+	LocalDeaths loaded;
+	// Opened by the loader on top of the loaded save
+	std::shared_ptr<DeathJournal> journal = std::make_shared<DeathJournal>();
+	// Set when the level is left before the load finished
+	bool abandoned = false;
+};
+
+// Updates the bars of a chart whose counts changed since the last call
+template <typename Histogram>
+static void drawChartBars(Histogram& histogram, vector<CCSprite*> const& bars,
+	int histHeight, bool redrawAll) {
+
+	auto dirty = histogram.takeDirty();
+	if (redrawAll) dirty.set();
+	if (dirty.none()) return;
+
+	float maximum = static_cast<float>(histogram.maximum());
+	for (size_t i = 0; i < bars.size(); i++) {
+		if (!dirty[i]) continue;
+
+		auto bar = bars[i];
+		uint32_t count = histogram.count(static_cast<int>(i));
+		bar->setVisible(count != 0);
+		if (count == 0) continue;
+
+		float distr = count / maximum;
+		auto color = heatColor(distr);
+		bar->setScaleY(distr * histHeight / bar->getContentHeight());
+		bar->setColor({
+			static_cast<uint8_t>(color.r * 255),
+			static_cast<uint8_t>(color.g * 255),
+			static_cast<uint8_t>(color.b * 255)
+		});
+	}
+
+}
+
 #include <Geode/modify/PlayLayer.hpp>
 class $modify(DMPlayLayer, PlayLayer) {
 
 	struct Fields {
 		// WebRequest response listener for death listing
 		EventListener<web::WebTask> m_listener;
+		// WebRequest response listener for the page being fetched, if paged
+		EventListener<web::WebTask> m_pageListener;
 
 		// Node holding all marker nodes
 		CCNode* m_dmNode = CCNode::create();
-		// Node on the progress bar holding its chart
-		CCDrawNode* m_chartNode = nullptr;
+		// Regular markers, all drawn from one texture in a single draw call
+		CCSpriteBatchNode* m_markerBatch = nullptr;
+		// Ghost cubes, which use several textures and can't be batched
+		CCNode* m_ghostNode = nullptr;
+		// Marker and ghost nodes in m_markerBatch and m_ghostNode, hidden
+		// instead of removed when markers are cleared
+		MarkerPool m_pool;
+		// When drawing GLOBAL, only deaths in [m_windowBegin, m_windowEnd)
+		// around the camera have nodes, held in m_windowNodes in that order
+		size_t m_windowBegin = 0;
+		size_t m_windowEnd = 0;
+		std::deque<CCNode*> m_windowNodes;
+		// Scale and rotation last applied to markers by updateMarkers,
+		// a negative scale makes it apply them again
+		float m_appliedScale = -1;
+		float m_appliedRotation = 0;
+
+		// Density of all deaths, drawn instead of markers when there are too
+		// many of them, see prefersHeatmap
+		CCNode* m_heatmapNode = nullptr;
+		// Number of deaths m_heatmapNode was or is being built from
+		size_t m_heatmapCount = 0;
+		bool m_heatmapShown = false;
+		bool m_heatmapBuilding = false;
+		// Node on the progress bar holding its chart, or at the top of the
+		// screen for platformer levels
+		CCSpriteBatchNode* m_chartNode = nullptr;
+		// One bar per percentage or time column in m_chartNode, only changed
+		// ones are updated
+		vector<CCSprite*> m_chartBars;
+		// Histogram height the bars were last drawn with
+		int m_chartHeight = 0;
 
 		// Current visibility of markers
 		DMDrawScope m_drawn = NONE;
 		// false if the level or settings will never result in markers being shown
 		bool m_willEverDraw = true;
 
-		// List of deaths
-		vector<unique_ptr<DeathLocationMin>> m_deaths;
-		// Iterator to an entry in m_deaths pointing to the death that was last added
-		vector<unique_ptr<DeathLocationMin>>::iterator m_latest;
+		// List of deaths, sorted by x
+		ChunkedDeathStore m_deaths;
+		// Deaths per percentage in m_deaths, for normal levels
+		PercentageHistogram m_histogram;
+		// Deaths per attempt time in m_deaths, for platformer levels
+		TimeHistogram m_timeHistogram;
+		// Death in m_deaths that was last added, if any
+		ChunkedDeathStore::Handle m_latest;
+		// Records new deaths when using local deaths
+		std::shared_ptr<DeathJournal> m_journal;
+		// Local deaths while they are being loaded
+		std::shared_ptr<LocalLoad> m_localLoad;
+		// Deaths recorded before m_journal was taken over from the loader
+		vector<DeathEntry> m_unjournaled;
 		// List of pending submissions, used to send on level exit
 		vector<DeathLocationOut> m_submissions;
 
@@ -67,6 +160,16 @@ class $modify(DMPlayLayer, PlayLayer) {
 		bool m_useLocal = false;
 		// Whether user settings signify only normal mode deaths should be shown
 		bool m_normalOnly = false;
+		// Whether deaths are fetched page by page as the player moves
+		bool m_paged = false;
+		// Pages of m_deaths held so far, if paged
+		DeathPager m_pager;
+		// Whether a page request is in flight, only one is at a time
+		bool m_pageInFlight = false;
+		// Seconds until the next page may be requested
+		float m_pageWait = 0;
+		// Page requests that failed in a row, for backing off
+		int m_pageFailures = 0;
 	};
 
 	bool init(GJGameLevel* level, bool useReplay, bool dontCreateObjects) {
@@ -77,6 +180,14 @@ class $modify(DMPlayLayer, PlayLayer) {
 		this->m_fields->m_dmNode->setID("markers"_spr);
 		this->m_fields->m_dmNode->setZOrder(2 << 28); // everyone using 99999 smh
 		this->m_objectLayer->addChild(this->m_fields->m_dmNode);
+		this->m_fields->m_markerBatch = CCSpriteBatchNode::create("death-marker.png"_spr);
+		this->m_fields->m_markerBatch->setID("marker-batch"_spr);
+		this->m_fields->m_dmNode->addChild(this->m_fields->m_markerBatch);
+		this->m_fields->m_ghostNode = CCNode::create();
+		this->m_fields->m_ghostNode->setID("ghosts"_spr);
+		this->m_fields->m_dmNode->addChild(this->m_fields->m_ghostNode);
+		this->m_fields->m_pool.setLayers(this->m_fields->m_markerBatch,
+			this->m_fields->m_ghostNode);
 
 		// refetch on level start in case it changed (player changed account)
 		// CONSIDER: Use GJAccountManager instead to ban unstable non-account users
@@ -85,8 +196,6 @@ class $modify(DMPlayLayer, PlayLayer) {
 		this->m_fields->m_playerProps.username =
 			GameManager::get()->m_playerName;
 
-		auto mod = Mod::get();
-
 		// save level data
 		this->m_fields->m_levelProps.levelId = level->m_levelID;
 		this->m_fields->m_levelProps.levelversion = level->m_levelVersion;
@@ -94,13 +203,10 @@ class $modify(DMPlayLayer, PlayLayer) {
 		this->m_fields->m_levelProps.practice = this->m_isPracticeMode;
 		this->m_fields->m_levelProps.testmode = this->m_isTestMode;
 
-		std::string storeLocalStr = mod->getSettingValue<std::string>("store-local-2");
-		this->m_fields->m_useLocal = storeLocalStr == "Always" ? true : storeLocalStr == "Never" ? false :
-			this->m_level->m_stars >= 10;
-		this->m_fields->m_normalOnly = mod->getSettingValue<bool>("normal-only");
-		GhostLocation::shouldUse = mod->getSettingValue<bool>("use-ghost-cube");
+		this->m_fields->m_useLocal = usesLocalDeaths(this->m_level->m_stars);
+		this->m_fields->m_normalOnly = settings.normalOnly;
 
-		log::debug("{} {} {}", storeLocalStr, this->m_level->m_stars, this->m_fields->m_useLocal);
+		log::debug("{} {} {}", settings.storeLocal, this->m_level->m_stars, this->m_fields->m_useLocal);
 
 		// Don't even continue to list if we're not going to show them anyway
 		this->m_fields->m_willEverDraw =
@@ -112,6 +218,7 @@ class $modify(DMPlayLayer, PlayLayer) {
 
 		this->m_fields->m_deaths.clear();
 		this->m_fields->m_submissions.clear();
+		this->m_fields->m_paged = this->shouldPage();
 
 		this->fetch(
 			[this](bool success) {
@@ -121,7 +228,8 @@ class $modify(DMPlayLayer, PlayLayer) {
 			}
 		);
 
-		this->schedule(schedule_selector(DMPlayLayer::updateMarkers), 0);
+		if (this->m_fields->m_paged)
+			this->schedule(schedule_selector(DMPlayLayer::updatePages), 0.25f);
 
 		return true;
 
@@ -142,38 +250,86 @@ class $modify(DMPlayLayer, PlayLayer) {
 		log::info("Listing Deaths...");
 
 		if (this->m_fields->m_useLocal) {
-			// Normally, when fetching we append, but this will not fail
-			// so we can safely clear and overwrite here.
-			this->m_fields->m_deaths.clear();
-			this->m_fields->m_deaths = getLocalDeaths(
-				this->m_fields->m_levelProps.levelId,
-				!this->m_fields->m_levelProps.platformer
-			);
-			log::debug("Finished parsing local saves.");
-			this->m_fields->m_fetched = true;
-			return cb(true);
+			// Saves can be arbitrarily large, keep reading them off the main thread
+			int levelId = this->m_fields->m_levelProps.levelId;
+			// Only the CSV saves of earlier versions leave out platformer times
+			bool csvHasPercentage = !this->m_fields->m_levelProps.platformer;
+			WeakRef<DMPlayLayer> self = this;
+			auto load = std::make_shared<LocalLoad>();
+			this->m_fields->m_localLoad = load;
+			runLocalIO([self, levelId, csvHasPercentage, load, cb]() {
+				load->loaded = getLocalDeaths(levelId, csvHasPercentage);
+				openLocalJournal(levelId, load->loaded.baseCount, load->journal.get());
+				queueInMainThread([self, load, cb]() {
+					// Deaths of a level left in the meantime are journaled by onQuit
+					if (load->abandoned) return;
+					auto layer = self.lock();
+					if (!layer) return;
+					layer->mergeLocalDeaths(*load);
+					cb(true);
+				});
+			});
+			return;
 		}
 
-		// Parse result JSON and add all as DeathLocationMin instances to playingLevel.deaths
+		if (this->m_fields->m_paged) {
+			// Markers can be shown as soon as the player's page is there
+			auto& pager = this->m_fields->m_pager;
+			this->requestPage(pager.pageOf(this->m_player1->getPositionX()),
+				[this, cb](bool success) {
+					if (success) this->m_fields->m_fetched = true;
+					cb(success);
+				});
+			return;
+		}
+
+		auto const& props = this->m_fields->m_levelProps;
+		auto cachePath = listCachePath(props.levelId, props.platformer,
+			!this->m_fields->m_normalOnly);
+		// Only the tag is read up front, so the server is only asked for what
+		// it adds to the cache. The cached deaths are loaded once it is known
+		// that they are needed.
+		auto cacheTag = readListCacheTag(cachePath);
+
+		// Parse result and merge all deaths into m_deaths
 		this->m_fields->m_listener.bind(
-			[this, cb](web::WebTask::Event* const e) {
+			[this, cb, cachePath, cacheTag](web::WebTask::Event* const e) {
 				auto res = e->getValue();
 				if (res) {
-					if (!res->ok()) {
+					if (res->code() == 304) {
+						log::debug("Death list unchanged, using cache.");
+						this->mergeCachedList(cachePath, nullptr,
+							std::nullopt, cb);
+					} else if (!res->ok()) {
 						log::error("Listing Deaths failed: {}",
 								   res->string().unwrapOr("Body could not be read."));
 						cb(false);
 					} else {
 						log::debug("Received death list.");
-						parseBinDeathList(res, &this->m_fields->m_deaths, !this->m_fields->m_levelProps.platformer);
-						sort(
-							this->m_fields->m_deaths.begin(),
-							this->m_fields->m_deaths.end(),
-							LocationComparerPtr{}
-						);
-						log::debug("Finished parsing.");
-						this->m_fields->m_fetched = true;
-
+						auto fetched = std::make_shared<DeathStore>();
+						if (parseBinDeathList(res, fetched.get(), true)) {
+							fetched->sortByX();
+
+							auto etag = res->header("ETag");
+							auto cursor = cursorHeader(res, "X-Death-Cursor");
+							std::optional<ListCacheTag> tag;
+							if (etag) tag = ListCacheTag{ *etag, cursor.value_or(0) };
+
+							// Only the deaths newer than the cache were sent
+							auto since = cursorHeader(res, "X-Death-Since");
+							if (cacheTag && since && *since == cacheTag->cursor) {
+								log::debug("Received {} new deaths.", fetched->size());
+								return this->mergeCachedList(cachePath, fetched, tag, cb);
+							}
+
+							// Whole lists can take megabytes, so they are written off
+							// the main thread as well. Both only read fetched.
+							if (tag) std::thread([cachePath, fetched, tag]() {
+								if (!writeListCache(cachePath, *fetched, true, *tag))
+									log::warn("Could not cache death list at {}.", cachePath);
+							}).detach();
+						}
+						this->mergeFetchedList(*fetched);
 						cb(true);
 					}
 				}
@@ -184,17 +340,193 @@ class $modify(DMPlayLayer, PlayLayer) {
 			}
 		);
 
-		// Build the HTTP Request
+		auto req = this->makeListRequest();
+		if (cacheTag) {
+			// Lets the server answer 304 if the cached list is still current,
+			// or send only the deaths added since it was cached
+			req.header("If-None-Match", cacheTag->etag);
+			if (cacheTag->cursor) req.param("since", cacheTag->cursor);
+		}
+
+		this->m_fields->m_listener.setFilter(req.get(dm::makeRequestURL("list")));
+
+	}
+
+	// Loads the cached list off the main thread, adds the deaths of fetched
+	// to it if there are any and caches the result under tag. Starts over
+	// without the cache if it turns out to be unreadable.
+	void mergeCachedList(std::filesystem::path const& cachePath,
+		std::shared_ptr<DeathStore> fetched, std::optional<ListCacheTag> tag,
+		std::function<void(bool)> cb) {
+
+		WeakRef<DMPlayLayer> self = this;
+		std::thread([self, cachePath, fetched, tag, cb]() {
+			auto cached = std::make_shared<DeathStore>();
+			bool const read = readListCache(cachePath, cached.get());
+			if (!read) dropListCache(cachePath);
+			else if (fetched) {
+				cached->merge(*fetched);
+				if (tag && !writeListCache(cachePath, *cached, true, *tag))
+					log::warn("Could not cache death list at {}.", cachePath);
+			}
+
+			queueInMainThread([self, cached, read, cb]() {
+				// Level may have been left in the meantime
+				auto layer = self.lock();
+				if (!layer) return;
+				if (!read) {
+					log::warn("Death list cache could not be read, listing again.");
+					return layer->fetch(cb);
+				}
+				layer->mergeFetchedList(*cached);
+				cb(true);
+			});
+		}).detach();
+
+	}
+
+	// Deaths may have been added while waiting, so the list is merged in
+	void mergeFetchedList(DeathStore const& fetched) {
+
+		this->m_fields->m_deaths.merge(fetched);
+		this->countDeaths(fetched.percentages());
+		log::debug("Finished parsing.");
+		this->m_fields->m_fetched = true;
+
+	}
+
+	// Builds the HTTP Request for /list, without any range or cache headers
+	web::WebRequest makeListRequest() {
+
+		auto const& props = this->m_fields->m_levelProps;
 		web::WebRequest req = web::WebRequest();
 
-		req.param("levelid", this->m_fields->m_levelProps.levelId);
-		req.param("platformer", this->m_fields->m_levelProps.platformer ? "true" : "false");
+		req.param("levelid", props.levelId);
+		req.param("platformer", props.platformer ? "true" : "false");
 		req.param("practice", this->m_fields->m_normalOnly ? "false" : "true");
-		req.param("response", "bin");
+		req.param("response", "bin2");
 		req.userAgent(HTTP_AGENT);
 		req.timeout(HTTP_TIMEOUT);
+		return req;
 
-		this->m_fields->m_listener.setFilter(req.get(dm::makeRequestURL("list")));
+	}
+
+	// Platformer levels can go on for minutes, while only deaths near the
+	// player are ever shown. Those are fetched a page at a time instead.
+	bool shouldPage() {
+
+		if (this->m_fields->m_useLocal) return false;
+		if (!this->m_fields->m_levelProps.platformer) return false;
+
+		// Drawing always shows every death at once
+		return settings.conditionNormal != DrawCondition::Always &&
+			settings.conditionPractice != DrawCondition::Always;
+
+	}
+
+	void requestPage(int page, std::function<void(bool)> cb) {
+
+		auto& pager = this->m_fields->m_pager;
+		pager.setRequested(page);
+		this->m_fields->m_pageInFlight = true;
+		this->m_fields->m_pageWait = PAGE_INTERVAL;
+
+		// Parse result and merge the page's deaths into m_deaths
+		this->m_fields->m_pageListener.bind(
+			[this, cb, page](web::WebTask::Event* const e) {
+				auto res = e->getValue();
+				if (!res && !e->isCancelled()) return;
+				this->m_fields->m_pageInFlight = false;
+
+				DeathStore fetched;
+				if (!res || !res->ok() ||
+					!parseBinDeathList(res, &fetched, true)) {
+					// Asked for again by updatePages, backing off in case the
+					// server is rate limiting or unreachable
+					auto& fields = this->m_fields;
+					fields->m_pager.setMissing(page);
+					fields->m_pageFailures = std::min(fields->m_pageFailures + 1, 8);
+					fields->m_pageWait = std::min(PAGE_MAX_BACKOFF,
+						PAGE_INTERVAL * (1 << fields->m_pageFailures));
+					log::error("Listing Deaths of page {} failed, retrying in {}s.",
+						page, fields->m_pageWait);
+					return cb(false);
+				}
+
+				this->m_fields->m_pageFailures = 0;
+
+				fetched.sortByX();
+				// Deaths may have been added while waiting
+				this->m_fields->m_deaths.merge(fetched);
+				this->countDeaths(fetched.percentages());
+				this->m_fields->m_pager.setLoaded(page);
+				log::debug("Received {} deaths of page {}.", fetched.size(), page);
+				cb(true);
+			}
+		);
+
+		auto req = this->makeListRequest();
+		req.param("xmin", pager.pageBegin(page));
+		req.param("xmax", pager.pageEnd(page));
+		this->m_fields->m_pageListener.setFilter(req.get(dm::makeRequestURL("list")));
+
+	}
+
+	// Drops pages the player left behind and fetches the next one around them,
+	// at most one every PAGE_INTERVAL seconds
+	void updatePages(float dt) {
+
+		this->m_fields->m_pageWait -= dt;
+		if (this->m_fields->m_pageInFlight || this->m_fields->m_pageWait > 0) return;
+
+		auto& pager = this->m_fields->m_pager;
+		auto& deaths = this->m_fields->m_deaths;
+		float x = this->m_player1->getPositionX();
+
+		for (int page : pager.takeEvictable(x)) {
+			size_t begin = deaths.lowerBound(pager.pageBegin(page));
+			size_t end = deaths.lowerBound(pager.pageEnd(page));
+			deaths.forEachSpan(begin, end, [this](auto const& span) {
+				this->uncountDeaths(span.percentage);
+			});
+			deaths.erase(begin, end);
+			// Draw conditions can change to "Always" while paging
+			this->eraseFromWindow(begin, end);
+		}
+
+		if (auto page = pager.nextMissing(x)) {
+			this->requestPage(*page, [this](bool success) {
+				// Retry of the page the level started in
+				if (!success || this->m_fields->m_fetched) return;
+				this->m_fields->m_fetched = true;
+				this->checkDraw(LEVEL_LOAD);
+			});
+		}
+
+	}
+
+	// Takes over deaths and the journal of the loader. Deaths recorded while
+	// they were loading are only in m_deaths and m_unjournaled so far and get
+	// journaled here.
+	void mergeLocalDeaths(LocalLoad& load) {
+
+		auto& deaths = this->m_fields->m_deaths;
+		auto& unjournaled = this->m_fields->m_unjournaled;
+		auto& loaded = load.loaded;
+
+		this->m_fields->m_journal = load.journal;
+		this->m_fields->m_localLoad = nullptr;
+
+		for (auto const& entry : unjournaled) this->m_fields->m_journal->append(entry);
+		if (!unjournaled.empty())
+			log::debug("Merged {} deaths recorded while loading.", unjournaled.size());
+		unjournaled.clear();
+
+		// Deaths of this session are counted already
+		this->countDeaths(loaded.deaths.percentages());
+		deaths.merge(loaded.deaths);
+		log::debug("Finished parsing local saves.");
+		this->m_fields->m_fetched = true;
 
 	}
 
@@ -224,7 +556,7 @@ class $modify(DMPlayLayer, PlayLayer) {
 		PlayLayer::levelComplete();
 		if (this->m_fields->m_levelProps.platformer) return;
 
-		auto deathLoc = DeathLocationOut(this->getPosition());
+		auto deathLoc = DeathLocationOut(toVec2(this->getPosition()));
 		deathLoc.percentage = 101;
 		this->m_fields->m_submissions.push_back(deathLoc);
 
@@ -244,158 +576,458 @@ class $modify(DMPlayLayer, PlayLayer) {
 		PlayLayer::onQuit();
 		this->submitDeaths();
 
-		if (this->m_fields->m_useLocal && this->m_fields->m_willEverDraw) {
-			storeLocalDeaths(
-				this->m_fields->m_levelProps.levelId,
-				this->m_fields->m_deaths,
-				!this->m_fields->m_levelProps.platformer
-			);
+		// Local deaths of this session are already journaled,
+		// this only waits for the last batch to be written
+		if (this->m_fields->m_journal) this->m_fields->m_journal->close();
+
+		// Still loading, the loader journals the deaths recorded until now
+		// once it is done, before the level can be loaded again
+		if (auto load = this->m_fields->m_localLoad) {
+			load->abandoned = true;
+			this->m_fields->m_localLoad = nullptr;
+			runLocalIO([load, unjournaled = std::move(this->m_fields->m_unjournaled)]() {
+				for (auto const& entry : unjournaled) load->journal->append(entry);
+				load->journal->close();
+				if (!unjournaled.empty())
+					log::debug("Journaled {} deaths recorded while loading.",
+						unjournaled.size());
+			});
+			this->m_fields->m_unjournaled.clear();
 		}
 
 		this->m_fields->m_deaths.clear();
+		this->resetCounts();
 
 	}
 
-	void renderMarkers(vector<unique_ptr<DeathLocationMin>>::iterator begin,
-		vector<unique_ptr<DeathLocationMin>>::iterator end, bool animate) {
+	void renderMarkers(size_t begin, size_t end, bool animate) {
 
-		if (end == this->m_fields->m_deaths.end()) {
+		auto const& deaths = this->m_fields->m_deaths;
+		if (end == deaths.size()) {
 			if (begin == end) return; // Nothing to draw
 			// Prevent crash
 			--end;
 		}
 
-		double fadeTime = Mod::get()->getSettingValue<float>("fade-time") / 2;
-		for (auto deathLoc = begin; deathLoc <= end; ++deathLoc) {
-			CCNode* node;
-			if (animate) node = (*deathLoc)->createAnimatedNode(
-				deathLoc == this->m_fields->m_latest,
+		auto& pool = this->m_fields->m_pool;
+		pool.reserve(end - begin + 1);
+
+		double fadeTime = settings.fadeTime / 2;
+		auto latest = this->m_fields->m_latest;
+		for (auto index = begin; index <= end; ++index) {
+			if (animate) pool.acquireAnimated(
+				deaths, index,
+				deaths.refersTo(latest, index),
 				(static_cast<double>(rand()) / RAND_MAX) * fadeTime,
 				fadeTime
 			);
-			else node = (*deathLoc)->createNode(deathLoc == this->m_fields->m_latest);
-			this->m_fields->m_dmNode->addChild(node);
+			else pool.acquire(deaths, index, deaths.refersTo(latest, index));
 		}
-		updateMarkers(0.0f);
+		refreshMarkers();
 
 	}
 
-	void updateMarkers(float) {
+	// Only scheduled while markers are drawn
+	void updateMarkers(float dt) {
+
+		this->m_fields->m_pool.animate(dt);
+
+		if (this->m_fields->m_drawn == GLOBAL && !this->m_fields->m_heatmapShown)
+			this->slideWindow();
 
 		auto sceneRotation = this->m_gameState.m_cameraAngle;
-		float inverseScale = Mod::get()->getSettingValue<float>("marker-scale") /
-			this->m_objectLayer->getScale();
+		float inverseScale = settings.markerScale / this->m_objectLayer->getScale();
 		if (inverseScale < 0) inverseScale *= -1;
 
-		auto children = this->m_fields->m_dmNode->getChildren();
-		for (int i = 0; i < this->m_fields->m_dmNode->getChildrenCount(); i++) {
-			auto child = static_cast<CCNode*>(children->objectAtIndex(i));
-			bool isCurrent = child->getZOrder() == CURRENT_ZORDER;
+		// Nothing to do unless the camera zoomed or turned, or nodes changed
+		if (inverseScale == this->m_fields->m_appliedScale &&
+			sceneRotation == this->m_fields->m_appliedRotation) return;
+		this->m_fields->m_appliedScale = inverseScale;
+		this->m_fields->m_appliedRotation = sceneRotation;
 
-			if (!cast::typeinfo_cast<SimplePlayer*>(child)) {
-				// Only for regular markers
-				child->setScale((isCurrent ? 1.5f : 1.0f) * inverseScale);
-				child->setRotation(-sceneRotation);
-			}
-		}
+		for (auto child : this->m_fields->m_pool.markers())
+			this->applyMarkerTransform(child);
 
 	}
 
-	void renderHistogram() {
+	// Scales a marker against the camera's zoom and turns it upright, as
+	// last applied by updateMarkers. Ghost cubes keep their own scale and
+	// rotation.
+	void applyMarkerTransform(CCNode* node) {
+
+		if (node->getParent() != this->m_fields->m_markerBatch) return;
+		bool isCurrent = node->getZOrder() == CURRENT_ZORDER;
+		node->setScale((isCurrent ? 1.5f : 1.0f) * this->m_fields->m_appliedScale);
+		node->setRotation(-this->m_fields->m_appliedRotation);
+
+	}
+
+	// Gives a node acquired between updates the transform of the others,
+	// unless all of them are about to be updated anyway
+	void placeAcquired(CCNode* node) {
+
+		if (this->m_fields->m_appliedScale >= 0) this->applyMarkerTransform(node);
+
+	}
+
+	// Applies scale and rotation to markers after nodes were added or changed
+	void refreshMarkers() {
 
-		int histHeight = Mod::get()->getSettingValue<int>("prog-bar-hist-height");
+		this->m_fields->m_appliedScale = -1;
+		this->updateMarkers(0.0f);
+
+	}
+
+	// Deaths are counted by percentage for normal levels and by attempt time,
+	// which is stored in place of the percentage, for platformer levels
+
+	void countDeath(int percentage) {
+
+		if (this->m_fields->m_levelProps.platformer)
+			this->m_fields->m_timeHistogram.add(percentage);
+		else this->m_fields->m_histogram.add(percentage);
+
+	}
+
+	void countDeaths(std::span<int const> percentages) {
+
+		if (this->m_fields->m_levelProps.platformer)
+			this->m_fields->m_timeHistogram.addAll(percentages);
+		else this->m_fields->m_histogram.addAll(percentages);
+
+	}
 
-		// Only Draw Histogram if requested and applicable
-		if (histHeight == 0 || this->m_fields->m_levelProps.platformer) return;
+	void uncountDeaths(std::span<int const> percentages) {
 
-		int hist[101] = { 0 };
+		if (this->m_fields->m_levelProps.platformer)
+			this->m_fields->m_timeHistogram.removeAll(percentages);
+		else this->m_fields->m_histogram.removeAll(percentages);
 
-		for (auto& deathLoc : this->m_fields->m_deaths) {
-			if (deathLoc->percentage >= 0 && deathLoc->percentage < 101)
-				hist[deathLoc->percentage]++;
+	}
+
+	void resetCounts() {
+
+		this->m_fields->m_histogram.clear();
+		this->m_fields->m_timeHistogram.clear();
+
+	}
+
+	void renderHistogram() {
+
+		int histHeight = settings.progBarHistHeight;
+		bool platformer = this->m_fields->m_levelProps.platformer;
+
+		// Only Draw Histogram if requested
+		if (histHeight == 0) {
+			if (this->m_fields->m_chartAttached)
+				this->m_fields->m_chartNode->setVisible(false);
+			return;
 		}
 
+		auto& bars = this->m_fields->m_chartBars;
 		if (!this->m_fields->m_chartAttached) {
-			auto progBarNode = this->m_progressBar;
-			if (!progBarNode) return;
+			// Platformer levels have no progress bar, their chart of attempt
+			// times hangs from the top of the screen instead
+			CCNode* parent;
+			CCPoint position;
+			float chartWidth;
+			int barCount;
+			if (platformer) {
+				parent = this->m_uiLayer;
+				if (!parent) return;
+				auto winSize = CCDirector::sharedDirector()->getWinSize();
+				chartWidth = PLATFORMER_CHART_WIDTH;
+				position = CCPoint((winSize.width - chartWidth) / 2, winSize.height);
+				barCount = TimeHistogram::columns;
+			} else {
+				parent = this->m_progressBar;
+				if (!parent) return;
+				chartWidth = parent->getContentWidth() - 4;
+				position = CCPoint(2, 4);
+				barCount = PercentageHistogram::bins;
+			}
 
-			this->m_fields->m_chartNode = CCDrawNode::create();
+			// Bars are tinted and scaled quads of one white texture, all drawn
+			// at once and only touched when their count changes
+			uint8_t const white[2 * 2 * 4] = {
+				0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+				0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+			};
+			auto texture = new CCTexture2D();
+			texture->initWithData(white, kCCTexture2DPixelFormat_RGBA8888, 2, 2,
+				CCSize(2, 2));
+			texture->autorelease();
+
+			this->m_fields->m_chartNode = CCSpriteBatchNode::createWithTexture(
+				texture, barCount
+			);
 			this->m_fields->m_chartNode->setID("chart"_spr);
 			this->m_fields->m_chartNode->setZOrder(-2);
-			this->m_fields->m_chartNode->setPosition(2, 4);
-			this->m_fields->m_chartNode->setContentWidth(
-				progBarNode->getContentWidth() - 4
-			);
-			progBarNode->addChild(this->m_fields->m_chartNode);
+			this->m_fields->m_chartNode->setPosition(position);
+			this->m_fields->m_chartNode->setContentWidth(chartWidth);
+
+			// The last percentage bar sits right of the progress bar's end
+			float width = chartWidth / (platformer ? barCount : 100);
+			for (int i = 0; i < barCount; i++) {
+				auto bar = CCSprite::createWithTexture(texture);
+				bar->setAnchorPoint({ 0, 1 });
+				bar->setPosition({ width * i, 0 });
+				bar->setScaleX(width / bar->getContentWidth());
+				bar->setVisible(false);
+				this->m_fields->m_chartNode->addChild(bar);
+				bars.push_back(bar);
+			}
+
+			parent->addChild(this->m_fields->m_chartNode);
 			this->m_fields->m_chartAttached = true;
+			this->m_fields->m_histogram.markAllDirty();
+			this->m_fields->m_timeHistogram.markAllDirty();
 		}
+		this->m_fields->m_chartNode->setVisible(true);
 
-		int maximum = hist[0];
-		float width = this->m_fields->m_chartNode->getContentWidth() / 100;
-
-		for (int i = 1; i <= 100; i++) {
-			if (hist[i] > maximum)
-				maximum = hist[i];
-		}
-
-		this->m_fields->m_chartNode->clear();
-		for (int i = 0; i <= 100; i++) {
-			if (hist[i] == 0) continue;
-
-			float distr = static_cast<float>(hist[i]) / maximum;
-			auto rect = CCRect(width * i, 0, width, -(distr * histHeight));
-			auto pos1 = CCPoint(width * i, 0);
-			auto pos2 = CCPoint(width * i + width, -(distr * histHeight));
-			ccColor4F color{};
-			color.r = 1 - ((1 - distr) * (1 - distr));
-			color.g = 1 - (distr * distr);
-			color.b = 0;
-			color.a = 1;
-
-			this->m_fields->m_chartNode->drawRect(pos1, pos2, color, 0.0f, color);
-		}
+		bool heightChanged = histHeight != this->m_fields->m_chartHeight;
+		this->m_fields->m_chartHeight = histHeight;
+		if (platformer)
+			drawChartBars(this->m_fields->m_timeHistogram, bars, histHeight, heightChanged);
+		else
+			drawChartBars(this->m_fields->m_histogram, bars, histHeight, heightChanged);
 
 	}
 
 	void clearMarkers() {
 
-		m_fields->m_dmNode->removeAllChildrenWithCleanup(true);
-		m_fields->m_dmNode->cleanup();
+		m_fields->m_pool.releaseAll();
+		m_fields->m_windowNodes.clear();
+		m_fields->m_windowBegin = m_fields->m_windowEnd = 0;
+		this->hideHeatmap();
 
 		if (!this->m_fields->m_chartAttached) return;
-		this->m_fields->m_chartNode->clear();
-		this->m_fields->m_chartNode->cleanup();
+		this->m_fields->m_chartNode->setVisible(false);
 
 	}
 
-	void findDeathRangeInFrame(
-		vector<unique_ptr<DeathLocationMin>>::iterator& begin,
-		vector<unique_ptr<DeathLocationMin>>::iterator& end,
+	// Finds begin, the last death left of the screen, and end, the first one
+	// right of it, or 0 and deaths.size() if there are none
+	void findDeathRangeInFrame(size_t& begin, size_t& end,
 		float lenience = 0.0f) {
 
 		// For all this jargon, see the "Screen Limit" slide in docs/doc.dio
 		auto winSize = CCDirector::sharedDirector()->getWinSize();
-		auto halfWinWidth = winSize.width / 2;
 		float winDiagonal =
 			(sqrt(winSize.width * winSize.width + winSize.height * winSize.height)
 			/ this->m_objectLayer->getScale() + 70) / 2;
-		// log::debug("{} {}", halfWinWidth, winDiagonal);
 
-		begin = binarySearchNearestXPosOnScreen(begin, end, this->m_objectLayer,
-			halfWinWidth - winDiagonal + min(lenience, 0.0f), false);
-		end = binarySearchNearestXPosOnScreen(begin, end, this->m_objectLayer,
-			halfWinWidth + winDiagonal + max(lenience, 0.0f), true);
+		// The screen fits in a circle around its center, which stays a circle
+		// of the same size in the object layer however the camera is turned
+		// or mirrored. Converting the center once leaves a plain search of x.
+		float centerX = this->m_objectLayer->convertToNodeSpace(
+			CCPoint(winSize.width / 2, winSize.height / 2)
+		).x;
+
+		auto const& deaths = this->m_fields->m_deaths;
+		size_t first = deaths.upperBound(centerX - winDiagonal + min(lenience, 0.0f));
+		begin = first > 0 ? first - 1 : 0;
+		end = deaths.upperBound(centerX + winDiagonal + max(lenience, 0.0f));
+		end = std::min(std::max(end, begin + 1), deaths.size());
 
 	}
 
 	void renderMarkersInFrame(bool animate) {
 
-		auto begin = this->m_fields->m_deaths.begin();
-		auto end = this->m_fields->m_deaths.end();
-
+		size_t begin, end;
 		findDeathRangeInFrame(begin, end);
 
-		renderMarkers(begin, end, animate);
+		if (prefersHeatmap(end - begin)) this->showHeatmap();
+		else renderMarkers(begin, end, animate);
+
+	}
+
+	void showHeatmap() {
+
+		auto const& deaths = this->m_fields->m_deaths;
+		this->m_fields->m_heatmapShown = true;
+		// An outdated heatmap is shown until the new one is built
+		if (this->m_fields->m_heatmapNode)
+			this->m_fields->m_heatmapNode->setVisible(true);
+		if (this->m_fields->m_heatmapBuilding) return;
+		if (this->m_fields->m_heatmapNode &&
+			this->m_fields->m_heatmapCount == deaths.size()) return;
+
+		this->m_fields->m_heatmapBuilding = true;
+		this->m_fields->m_heatmapCount = deaths.size();
+		WeakRef<DMPlayLayer> self = this;
+		std::vector<float> xs, ys;
+		xs.reserve(deaths.size());
+		ys.reserve(deaths.size());
+		deaths.forEachSpan(0, deaths.size(), [&xs, &ys](auto const& span) {
+			xs.insert(xs.end(), span.x.begin(), span.x.end());
+			ys.insert(ys.end(), span.y.begin(), span.y.end());
+		});
+		buildHeatmapNode(
+			std::move(xs),
+			std::move(ys),
+			[self](CCNode* node) {
+				// Level may have been left in the meantime
+				auto layer = self.lock();
+				if (!layer) return;
+
+				auto& fields = layer->m_fields;
+				fields->m_heatmapBuilding = false;
+				if (fields->m_heatmapNode) fields->m_heatmapNode->removeFromParent();
+				fields->m_heatmapNode = node;
+				node->setZOrder(-1);
+				node->setVisible(fields->m_heatmapShown);
+				fields->m_dmNode->addChild(node);
+			}
+		);
+
+	}
+
+	void hideHeatmap() {
+
+		this->m_fields->m_heatmapShown = false;
+		if (this->m_fields->m_heatmapNode)
+			this->m_fields->m_heatmapNode->setVisible(false);
+
+	}
+
+	// Deaths that should have nodes while drawing GLOBAL, as [begin, end)
+	void findWindow(size_t& begin, size_t& end) {
+
+		auto const& deaths = this->m_fields->m_deaths;
+		begin = end = 0;
+		if (deaths.empty()) return;
+
+		// Deaths the player is moving towards are added a little early
+		findDeathRangeInFrame(begin, end, this->m_player1->m_isGoingLeft ?
+			-WINDOW_LENIENCE : WINDOW_LENIENCE);
+		// end is the first death past the screen, or deaths.size()
+		end = std::min(end + 1, deaths.size());
+
+	}
+
+	CCNode* acquireWindowNode(size_t index, bool animate, double fadeTime) {
+
+		auto& pool = this->m_fields->m_pool;
+		auto const& deaths = this->m_fields->m_deaths;
+		bool isCurrent = deaths.refersTo(this->m_fields->m_latest, index);
+		if (!animate) return pool.acquire(deaths, index, isCurrent);
+		return pool.acquireAnimated(deaths, index, isCurrent,
+			(static_cast<double>(rand()) / RAND_MAX) * fadeTime, fadeTime);
+
+	}
+
+	// Draws all markers, giving nodes only to those around the camera
+	void renderWindow(bool animate) {
+
+		size_t begin, end;
+		this->findWindow(begin, end);
+		this->m_fields->m_pool.reserve(end - begin);
+
+		double fadeTime = settings.fadeTime / 2;
+		for (size_t index = begin; index < end; index++)
+			this->m_fields->m_windowNodes.push_back(
+				this->acquireWindowNode(index, animate, fadeTime)
+			);
+		this->m_fields->m_windowBegin = begin;
+		this->m_fields->m_windowEnd = end;
+
+	}
+
+	// Moves the window along with the camera, only adding and removing the
+	// nodes at its edges
+	void slideWindow() {
+
+		size_t begin, end;
+		this->findWindow(begin, end);
+
+		auto& pool = this->m_fields->m_pool;
+		auto& nodes = this->m_fields->m_windowNodes;
+		auto& windowBegin = this->m_fields->m_windowBegin;
+		auto& windowEnd = this->m_fields->m_windowEnd;
+		if (begin == windowBegin && end == windowEnd) return;
+
+		// Jumped past the whole window, e.g. on respawn
+		if (begin >= windowEnd || end <= windowBegin) {
+			for (auto node : nodes) pool.release(node);
+			nodes.clear();
+			windowBegin = windowEnd = begin;
+		}
+
+		while (windowBegin < begin) {
+			pool.release(nodes.front());
+			nodes.pop_front();
+			windowBegin++;
+		}
+		while (windowEnd > end) {
+			pool.release(nodes.back());
+			nodes.pop_back();
+			windowEnd--;
+		}
+		// Only the nodes added here need the camera's transform
+		while (windowBegin > begin) {
+			windowBegin--;
+			nodes.push_front(this->acquireWindowNode(windowBegin, false, 0));
+			this->placeAcquired(nodes.front());
+		}
+		while (windowEnd < end) {
+			nodes.push_back(this->acquireWindowNode(windowEnd, false, 0));
+			this->placeAcquired(nodes.back());
+			windowEnd++;
+		}
+
+	}
+
+	// Keeps the window in line with m_deaths after a death was inserted at
+	// index, giving it an animated node if it is in the window
+	void insertIntoWindow(size_t index) {
+
+		if (this->m_fields->m_drawn != GLOBAL || this->m_fields->m_heatmapShown)
+			return;
+
+		auto& windowBegin = this->m_fields->m_windowBegin;
+		auto& windowEnd = this->m_fields->m_windowEnd;
+		if (index < windowBegin) {
+			windowBegin++;
+			windowEnd++;
+			return;
+		}
+		if (index > windowEnd) return;
+
+		double fadeTime = settings.fadeTime / 2;
+		auto& nodes = this->m_fields->m_windowNodes;
+		auto node = this->m_fields->m_pool.acquireAnimated(
+			this->m_fields->m_deaths, index, true, 0, fadeTime
+		);
+		nodes.insert(nodes.begin() + (index - windowBegin), node);
+		this->placeAcquired(node);
+		windowEnd++;
+
+	}
+
+	// Keeps the window in line with m_deaths after the deaths in [begin, end)
+	// were erased. Evicted pages lie behind the player, so this usually only
+	// shifts the window, nodes are handed out again if it overlapped them.
+	void eraseFromWindow(size_t begin, size_t end) {
+
+		if (this->m_fields->m_drawn != GLOBAL || this->m_fields->m_heatmapShown)
+			return;
+		if (begin == end) return;
+
+		auto& windowBegin = this->m_fields->m_windowBegin;
+		auto& windowEnd = this->m_fields->m_windowEnd;
+		if (begin >= windowEnd) return;
+		if (end <= windowBegin) {
+			windowBegin -= end - begin;
+			windowEnd -= end - begin;
+			return;
+		}
+
+		auto& nodes = this->m_fields->m_windowNodes;
+		for (auto node : nodes) this->m_fields->m_pool.release(node);
+		nodes.clear();
+		this->renderWindow(false);
+		this->refreshMarkers();
 
 	}
 
@@ -404,22 +1036,20 @@ class $modify(DMPlayLayer, PlayLayer) {
 
 		if (!this->m_fields->m_willEverDraw) return NONE;
 
-		auto mod = Mod::get();
-		auto pauseSetting = mod->getSettingValue<bool>("show-in-pause");
-		if (pauseSetting && this->m_isPaused) return LOCAL;
+		if (settings.showInPause && this->m_isPaused) return LOCAL;
 
 		bool isPractice = this->m_fields->m_levelProps.practice ||
 			this->m_fields->m_levelProps.testmode;
-		auto settName = isPractice ? "condition-practice" : "condition-normal";
 		// Relevant condition setting for current mode
-		auto condSetting = mod->getSettingValue<std::string>(settName);
+		auto condSetting = isPractice ?
+			settings.conditionPractice : settings.conditionNormal;
 
-		if (condSetting == "Always") return GLOBAL;
-		if (condSetting == "Never") return NONE;
+		if (condSetting == DrawCondition::Always) return GLOBAL;
+		if (condSetting == DrawCondition::Never) return NONE;
 		// Remainder: On Death
 		if (!this->m_player1->m_isDead && !this->m_player2->m_isDead) return NONE;
 
-		if (!mod->getSettingValue<bool>("newbest-only")) return LOCAL;
+		if (!settings.newbestOnly) return LOCAL;
 		if (this->m_fields->m_levelProps.platformer) return LOCAL;
 
 		int best = isPractice ?
@@ -449,47 +1079,59 @@ class $modify(DMPlayLayer, PlayLayer) {
 					renderHistogram();
 					if (this->m_fields->m_drawn == NONE) {
 						renderMarkersInFrame(event != PAUSE);
-						// iterator equivalent of nullptr
-						this->m_fields->m_latest = this->m_fields->m_deaths.end();
+						this->m_fields->m_latest = {};
 					} else
 						// Markers are already globally rendered, so do not rerender
 						// Override `should` to prevent rerendering when switching to GLOBAL
 						should = GLOBAL;
 					break;
-				case GLOBAL:
+				case GLOBAL: {
 					renderHistogram();
 					if (this->m_fields->m_drawn == LOCAL) clearMarkers();
-					renderMarkers(
-						this->m_fields->m_deaths.begin(),
-						this->m_fields->m_deaths.end(),
-						true
-					);
+					// Decided by the deaths around the camera, as only those
+					// get markers
+					size_t begin, end;
+					this->findWindow(begin, end);
+					if (prefersHeatmap(end - begin)) showHeatmap();
+					else renderWindow(true);
+					refreshMarkers();
 					break;
+				}
 			}
+			// Nothing to keep up to date while no markers are drawn
+			if (should == NONE)
+				this->unschedule(schedule_selector(DMPlayLayer::updateMarkers));
+			else if (this->m_fields->m_drawn == NONE)
+				this->schedule(schedule_selector(DMPlayLayer::updateMarkers), 0);
 			this->m_fields->m_drawn = should;
 		} else if (event == DEATH && should) {
 			// = markers are not redrawn, but new one should appear
-			if (this->m_fields->m_latest == this->m_fields->m_deaths.end()) return;
-
-			double fadeTime = Mod::get()->getSettingValue<float>("fade-time") / 2;
-			auto node = (*this->m_fields->m_latest)->createAnimatedNode(
-				true, 0, fadeTime
-			);
-			this->m_fields->m_dmNode->addChild(node);
-			updateMarkers(0.0f);
+			size_t latest = this->m_fields->m_deaths.indexOf(this->m_fields->m_latest);
+			if (latest == ChunkedDeathStore::npos) return;
+
+			// When drawing GLOBAL markers, insertIntoWindow already added it
+			if (this->m_fields->m_drawn != GLOBAL || this->m_fields->m_heatmapShown) {
+				double fadeTime = settings.fadeTime / 2;
+				this->m_fields->m_pool.acquireAnimated(
+					this->m_fields->m_deaths, latest, true, 0, fadeTime
+				);
+			}
+			refreshMarkers();
 
-			this->m_fields->m_latest = this->m_fields->m_deaths.end();
+			this->m_fields->m_latest = {};
 			renderHistogram();
 		} else if (event == RESET && should) {
 			// = markers are not redrawn, but last one should shrink
 
 			// reset all nodes to regular z-order
-			auto children = this->m_fields->m_dmNode->getChildren();
-			for (int i = 0; i < this->m_fields->m_dmNode->getChildrenCount(); i++) {
-				static_cast<CCNode*>(children->objectAtIndex(i))
-					->setZOrder(OTHER_ZORDER);
-			}
-			updateMarkers(0.0f);
+			auto const& pool = this->m_fields->m_pool;
+			auto resetZOrder = [](CCNode* node) {
+				// Reordering a batch node child sorts all of its children
+				if (node->getZOrder() != OTHER_ZORDER) node->setZOrder(OTHER_ZORDER);
+			};
+			for (auto node : pool.markers()) resetZOrder(node);
+			for (auto node : pool.ghosts()) resetZOrder(node);
+			refreshMarkers();
 		}
 	}
 
@@ -498,7 +1140,10 @@ class $modify(DMPlayLayer, PlayLayer) {
 		if (!dm::shouldSubmit(this->m_fields->m_levelProps,
 			this->m_fields->m_playerProps)) return;
 
+		auto const unpurged = this->m_fields->m_submissions.size();
 		purgeSpam(this->m_fields->m_submissions);
+		log::debug("Spam Removal: {} -> {} deaths.", unpurged,
+			this->m_fields->m_submissions.size());
 		if (this->m_fields->m_submissions.size() == 0) return;
 
 		auto mod = Mod::get();
@@ -512,6 +1157,10 @@ class $modify(DMPlayLayer, PlayLayer) {
 			this->m_level->m_levelVersion
 		));
 		myjson.set("format", matjson::Value(FORMAT_VERSION));
+		// Lets the server keep times of death past 99 seconds
+		myjson.set("platformer", matjson::Value(
+			this->m_fields->m_levelProps.platformer
+		));
 
 		// Create Userident
 		std::string source = fmt::format("{}_{}_{}",
@@ -528,7 +1177,7 @@ class $modify(DMPlayLayer, PlayLayer) {
 		auto deathList = matjson::Value(vector<matjson::Value>());
 		for (auto i : this->m_fields->m_submissions) {
 			auto obj = matjson::Value();
-			i.addToJSON(&obj);
+			addToJSON(i, &obj);
 			deathList.push(obj);
 		}
 		myjson.set("deaths", deathList);
@@ -575,9 +1224,8 @@ class $modify(DMPlayerObject, PlayerObject) {
 		int percent = playLayer->m_fields->m_levelProps.platformer ?
 			static_cast<int>(playLayer->m_attemptTime) :
 			playLayer->getCurrentPercentInt();
-		auto deathLoc = std::make_unique<DeathLocationOut>
-			(DeathLocationOut{this->getPosition()});
-		deathLoc->percentage = percent;
+		auto deathLoc = DeathLocationOut(toVec2(this->getPosition()));
+		deathLoc.percentage = percent;
 		// deathLoc->coin1 = ...; // This stuff is complicated... prolly gonna pr Weebifying/coins-in-pause-menu-geode to make it api public and depend on it here or sm
 		// deathLoc->coin2 = ...;
 		// deathLoc->coin3 = ...;
@@ -585,29 +1233,33 @@ class $modify(DMPlayerObject, PlayerObject) {
 
 		bool isPractice = playLayer->m_fields->m_levelProps.practice ||
 			playLayer->m_fields->m_levelProps.testmode;
-		deathLoc->practice = isPractice;
+		deathLoc.practice = isPractice;
 
-		playLayer->m_fields->m_submissions.push_back(*deathLoc);
+		playLayer->m_fields->m_submissions.push_back(deathLoc);
 
 		if (!playLayer->m_fields->m_normalOnly || !isPractice) {
-			auto nearest = binarySearchNearestXPos(
-				playLayer->m_fields->m_deaths.begin(),
-				playLayer->m_fields->m_deaths.end(),
-				deathLoc->pos.x, true
-			);
-
-			unique_ptr<DeathLocationMin> toShow;
-			if (Mod::get()->getSettingValue<bool>("use-ghost-cube") &&
+			std::optional<GhostPose> ghost;
+			if (settings.useGhostCube &&
 				playLayer->m_fields->m_useLocal
-			) {
-				auto showGhost = std::make_unique<GhostLocation>(GhostLocation(this));
-				showGhost->percentage = percent;
-				toShow = std::move(showGhost);
-			} else
-				toShow = std::move(deathLoc);
-
-			playLayer->m_fields->m_latest =
-				playLayer->m_fields->m_deaths.insert(nearest, std::move(toShow));
+			) ghost = makeGhostPose(this);
+
+			playLayer->m_fields->m_latest = playLayer->m_fields->m_deaths.insert(
+				deathLoc.pos, percent, ghost
+			);
+			playLayer->countDeath(percent);
+			playLayer->insertIntoWindow(
+				playLayer->m_fields->m_deaths.indexOf(playLayer->m_fields->m_latest)
+			);
+			// Keeps the death around when its page is dropped, it is not on the
+			// server yet
+			auto& pager = playLayer->m_fields->m_pager;
+			pager.pin(pager.pageOf(deathLoc.pos.x));
+			// Not open until local deaths are loaded, which journals this one
+			DeathEntry entry{ deathLoc.pos, percent, ghost };
+			auto& journal = playLayer->m_fields->m_journal;
+			if (journal && journal->isOpen()) journal->append(entry);
+			else if (playLayer->m_fields->m_localLoad)
+				playLayer->m_fields->m_unjournaled.push_back(entry);
 		}
 		playLayer->checkDraw(DEATH);
 
@@ -646,16 +1298,12 @@ class $modify(DMPauseLayer, PauseLayer) {
 						});
 
 					this->m_fields->m_listener->bind([](geode::Popup<geode::Mod*>::CloseEvent* e) {
-						auto mod = Mod::get();
-
 						auto playLayer = static_cast<DMPlayLayer*>(PlayLayer::get());
 						if (!playLayer->m_fields->m_willEverDraw) return;
 
-						auto storeLocalStr = mod->getSettingValue<std::string>("store-local-2");
-						auto useLocal = storeLocalStr == "Always" ? true : storeLocalStr == "Never" ? false :
-							playLayer->m_level->m_stars >= 10;
-						auto normalOnly = mod->getSettingValue<bool>("normal-only");
-						GhostLocation::shouldUse = mod->getSettingValue<bool>("use-ghost-cube");
+						// settings is already up to date
+						auto useLocal = usesLocalDeaths(playLayer->m_level->m_stars);
+						auto normalOnly = settings.normalOnly;
 
 						playLayer->checkDraw(PAUSE);
 
@@ -735,4 +1383,6 @@ $execute {
 
 	mod->setSavedValue("setting-version", settingVersion);
 
+	watchSettings();
+
 };
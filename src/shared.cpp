@@ -1,133 +1,56 @@
+#include <algorithm>
+#include <charconv>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "shared.hpp"
 
 using namespace dm;
 
-DeathLocationMin::DeathLocationMin(float x, float y, int percentage) {
-	this->pos = CCPoint(x, y);
-	this->percentage = percentage;
-}
-
-DeathLocationMin::DeathLocationMin(CCPoint pos, int percentage) {
-	this->pos = pos;
-	this->percentage = percentage;
-}
-
-DeathLocationMin::DeathLocationMin(float x, float y) {
-	this->pos = CCPoint(x, y);
-	this->percentage = 0;
-}
-
-DeathLocationMin::DeathLocationMin(CCPoint pos) {
-	this->pos = pos;
-	this->percentage = 0;
-}
-
-CCNode* DeathLocationMin::createNode(bool isCurrent) const {
-	return this->createNode(isCurrent, false);
-}
-
-CCNode* DeathLocationMin::createAnimatedNode(
-	bool isCurrent, double delay, double fadeTime) const {
-	auto node = this->createNode(isCurrent, true);
-	if (delay || fadeTime)
-		node->runAction(CCSequence::createWithTwoActions(
-			CCDelayTime::create(delay),
-			CCSpawn::createWithTwoActions(
-				CCEaseBounceOut::create(
-					CCMoveTo::create(fadeTime, this->pos)
-				),
-				CCFadeIn::create(fadeTime)
-			)
-		));
-	return node;
-}
+static void placeMarkerNode(CCSprite* sprite, Vec2 pos, bool isCurrent,
+	bool preAnim) {
 
-CCNode* DeathLocationMin::createNode(bool isCurrent, bool preAnim) const {
-	auto sprite = CCSprite::create("death-marker.png"_spr);
-	float markerScale = Mod::get()->getSettingValue<float>("marker-scale");
-
-	sprite->setZOrder(isCurrent ? CURRENT_ZORDER : OTHER_ZORDER);
+	int zOrder = isCurrent ? CURRENT_ZORDER : OTHER_ZORDER;
+	// Reordering a batch node child sorts all of its children
+	if (sprite->getZOrder() != zOrder) sprite->setZOrder(zOrder);
+	sprite->setVisible(true);
 
 	if (preAnim) {
-		auto point = CCPoint(this->pos.x, this->pos.y + markerScale * 4);
+		auto point = CCPoint(pos.x, pos.y + settings.markerScale * 4);
 		sprite->setPosition(point);
 		sprite->setOpacity(0);
 	}
 	else {
-		sprite->setPosition(this->pos);
+		sprite->setPosition(toCCPoint(pos));
+		sprite->setOpacity(0xff);
 	}
-	sprite->setAnchorPoint({ 0.5f, 0.0f });
-	return sprite;
 }
 
-void DeathLocationMin::printCSV(ostream& os, bool hasPercentage) const {
-	os << this->pos.x << ',' << this->pos.y;
-	if (hasPercentage) os << ',' << this->percentage;
-};
-
-
-GhostLocation::GhostLocation(PlayerObject* player) :
-	DeathLocationMin(player->getPosition()) {
-	this->isPlayer2 = player->m_isSecondPlayer;
-	this->isMini = player->m_vehicleSize == 0.6f;
-	this->isFlipped = player->m_isUpsideDown;
-	this->isMirrored = player->m_isGoingLeft;
-	this->rotation = player->m_fRotationX;
-
-	if (player->m_isShip) {
-		this->mode = player->m_isPlatformer ? IconType::Jetpack : IconType::Ship;
-	} else if (player->m_isBall) {
-		this->mode = IconType::Ball;
-	} else if (player->m_isBird) {
-		this->mode = IconType::Ufo;
-	} else if (player->m_isDart) {
-		this->mode = IconType::Wave;
-	} else if (player->m_isRobot) {
-		this->mode = IconType::Robot;
-	} else if (player->m_isSpider) {
-		this->mode = IconType::Spider;
-	} else if (player->m_isSwing) {
-		this->mode = IconType::Swing;
-	} else {
-		this->mode = IconType::Cube;
-	}
+static CCSprite* createMarkerNode(Vec2 pos, bool isCurrent, bool preAnim) {
+	auto sprite = CCSprite::create("death-marker.png"_spr);
+	sprite->setAnchorPoint({ 0.5f, 0.0f });
+	placeMarkerNode(sprite, pos, isCurrent, preAnim);
+	return sprite;
 }
 
-GhostLocation::GhostLocation(float x, float y) :
-	DeathLocationMin(x, y) {};
-
-GhostLocation::GhostLocation(float x, float y, int percentage) :
-	DeathLocationMin(x, y, percentage) {};
-
-CCNode* GhostLocation::createAnimatedNode(
-	bool isCurrent, double delay, double fadeTime) const {
-
-	if (!GhostLocation::shouldUse)
-		return DeathLocationMin::createAnimatedNode(isCurrent, delay, fadeTime);
-
-	auto node = this->createNode(isCurrent, true);
-	if (delay || fadeTime)
-		node->runAction(CCSequence::createWithTwoActions(
-			CCDelayTime::create(delay),
-			CCSpawn::createWithTwoActions(
-				CCEaseBounceOut::create(
-					CCScaleTo::create(fadeTime, isMini ? 0.6f : 1.0f)
-				),
-				CCFadeTo::create(fadeTime, 0xff / 2)
-			)
-		));
-	return node;
+// Ghost cubes of poses with the same key look the same apart from what
+// placeGhostNode sets
+static int ghostKey(GhostPose const& pose) {
+	return pose.mode * 2 + pose.isPlayer2;
 }
 
-CCNode* GhostLocation::createNode(bool isCurrent, bool preAnim) const {
+// Side length of the texture a ghost cube is rendered to, with room for the
+// cube riding a ship or UFO
+constexpr int GHOST_TEXTURE_SIZE = 80;
 
-	if (!GhostLocation::shouldUse)
-		return DeathLocationMin::createNode(isCurrent, preAnim);
+static CCNode* buildGhostNode(GhostPose const& pose) {
 
 	auto gm = GameManager::sharedState();
+	auto mode = static_cast<IconType>(pose.mode);
 
 	int frameIcon;
-	switch (this->mode) {
+	switch (mode) {
 		case IconType::Ship: frameIcon = gm->getPlayerShip(); break;
 		case IconType::Ball: frameIcon = gm->getPlayerBall(); break;
 		case IconType::Ufo: frameIcon = gm->getPlayerBird(); break;
@@ -142,11 +65,11 @@ CCNode* GhostLocation::createNode(bool isCurrent, bool preAnim) const {
 	auto col1 = gm->getPlayerColor();
 	auto col2 = gm->getPlayerColor2();
 	auto glowOutline = gm->colorForIdx(gm->getPlayerGlowColor());
-	if (this->isPlayer2) std::swap(col1, col2);
+	if (pose.isPlayer2) std::swap(col1, col2);
 
 	SimplePlayer* sprite = SimplePlayer::create(0);
-	if (this->mode == IconType::Ship || this->mode == IconType::Ufo ||
-		this->mode == IconType::Jetpack
+	if (mode == IconType::Ship || mode == IconType::Ufo ||
+		mode == IconType::Jetpack
 	) {
 		auto miniPlayer = SimplePlayer::create(0);
 
@@ -164,7 +87,7 @@ CCNode* GhostLocation::createNode(bool isCurrent, bool preAnim) const {
 		miniPlayer->setAnchorPoint({ 0.5f, 0.5f });
 		miniPlayer->setOpacity(0xff / 2);
 
-		switch (this->mode) {
+		switch (mode) {
 			case IconType::Ship:
 				miniPlayer->setPosition({0, 10});
 				miniPlayer->setScale(0.55f);
@@ -184,7 +107,7 @@ CCNode* GhostLocation::createNode(bool isCurrent, bool preAnim) const {
 		sprite->addChild(miniPlayer);
 	}
 
-	sprite->updatePlayerFrame(frameIcon, this->mode);
+	sprite->updatePlayerFrame(frameIcon, mode);
 	sprite->setColors(
 		grayscale(gm->colorForIdx(col1)),
 		grayscale(gm->colorForIdx(col2))
@@ -194,61 +117,336 @@ CCNode* GhostLocation::createNode(bool isCurrent, bool preAnim) const {
 	if (!gm->getPlayerGlow())
 		sprite->disableGlowOutline();
 
-	sprite->setRotation(this->rotation);
-	if (mode != IconType::Ball && mode != IconType::Swing) {
-		if (this->isFlipped) sprite->m_fRotationX += 180.0f;
-		if (this->isMirrored) sprite->m_fRotationY += 180.0f;
-	}
-	sprite->setScale(1.0f / (1 << (preAnim + isMini)));
-
-	sprite->setOpacity(preAnim ? 0 : 0xff / 2);
 	sprite->setCascadeOpacityEnabled(true);
-	sprite->setPosition(pos);
-	if (this->mode == IconType::Ship) sprite->setPosition(pos + CCPoint(0, -5));
-	sprite->setZOrder(isCurrent ? CURRENT_ZORDER : OTHER_ZORDER);
 	sprite->setAnchorPoint({ 0.5f, 0.5f });
 	return sprite;
 }
 
-void GhostLocation::printCSV(ostream& os, bool hasPercentage) const {
-	uint8_t flagField = 0;
-	flagField |= (this->isPlayer2 << 0);
-	flagField |= (this->isMini << 1);
-	flagField |= (this->isFlipped << 2);
-	flagField |= (this->isMirrored << 3);
+// Renders the icon, colours and glow of the player once, so ghost cubes can
+// be plain sprites of the result
+static CCRenderTexture* renderGhost(GhostPose const& pose) {
+	auto node = buildGhostNode(pose);
+	node->setPosition({ GHOST_TEXTURE_SIZE / 2.0f, GHOST_TEXTURE_SIZE / 2.0f });
+
+	auto texture = CCRenderTexture::create(GHOST_TEXTURE_SIZE, GHOST_TEXTURE_SIZE);
+	texture->beginWithClear(0, 0, 0, 0);
+	node->visit();
+	texture->end();
+	return texture;
+}
 
-	os << this->pos.x << ',' << this->pos.y
-		 << ',' << this->rotation << ',' << static_cast<int>(this->mode) << ','
-		 << static_cast<int>(flagField);
-	if (hasPercentage) os << ',' << this->percentage;
-};
+static void placeGhostNode(CCNode* sprite, Vec2 pos, GhostPose const& pose,
+	bool isCurrent, bool preAnim) {
+
+	auto mode = static_cast<IconType>(pose.mode);
+
+	sprite->setRotation(pose.rotation);
+	if (mode != IconType::Ball && mode != IconType::Swing) {
+		if (pose.isFlipped) sprite->m_fRotationX += 180.0f;
+		if (pose.isMirrored) sprite->m_fRotationY += 180.0f;
+	}
+	sprite->setScale(1.0f / (1 << (preAnim + pose.isMini)));
+
+	static_cast<CCSprite*>(sprite)->setOpacity(preAnim ? 0 : 0xff / 2);
+	sprite->setPosition(toCCPoint(pos));
+	if (mode == IconType::Ship) sprite->setPosition(toCCPoint(pos) + CCPoint(0, -5));
+	int zOrder = isCurrent ? CURRENT_ZORDER : OTHER_ZORDER;
+	if (sprite->getZOrder() != zOrder) sprite->setZOrder(zOrder);
+	sprite->setVisible(true);
+}
+
+// Same curve as CCEaseBounceOut
+static float bounceOut(float time) {
+	if (time < 1 / 2.75f) return 7.5625f * time * time;
+	if (time < 2 / 2.75f) {
+		time -= 1.5f / 2.75f;
+		return 7.5625f * time * time + 0.75f;
+	}
+	if (time < 2.5f / 2.75f) {
+		time -= 2.25f / 2.75f;
+		return 7.5625f * time * time + 0.9375f;
+	}
+	time -= 2.625f / 2.75f;
+	return 7.5625f * time * time + 0.984375f;
+}
+
+void MarkerAnimator::addMarker(CCSprite* node, Vec2 pos, float delay,
+	float duration) {
+	this->m_animations.push_back({
+		node, this->m_time + delay, duration, false,
+		node->getPosition(), toCCPoint(pos)
+	});
+}
+
+void MarkerAnimator::addGhost(CCSprite* node, float scale, float delay,
+	float duration) {
+	this->m_animations.push_back({
+		node, this->m_time + delay, duration, true,
+		CCPoint(node->getScale(), 0), CCPoint(scale, 0)
+	});
+}
+
+void MarkerAnimator::cancel(CCNode* node) {
+	auto it = std::find_if(this->m_animations.begin(), this->m_animations.end(),
+		[node](Animation const& animation) { return animation.node == node; });
+	if (it == this->m_animations.end()) return;
+	*it = this->m_animations.back();
+	this->m_animations.pop_back();
+}
+
+void MarkerAnimator::clear() {
+	this->m_animations.clear();
+	this->m_time = 0;
+}
+
+void MarkerAnimator::update(float dt) {
+	if (this->m_animations.empty()) return;
+	this->m_time += dt;
+
+	for (size_t i = 0; i < this->m_animations.size();) {
+		auto const& animation = this->m_animations[i];
+		float elapsed = this->m_time - animation.start;
+		if (elapsed < 0) {
+			i++;
+			continue;
+		}
+
+		float progress = animation.duration > 0 ?
+			std::min(elapsed / animation.duration, 1.0f) : 1.0f;
+		float eased = bounceOut(progress);
+		auto value = animation.from + (animation.to - animation.from) * eased;
+		if (animation.isGhost) {
+			animation.node->setScale(value.x);
+			animation.node->setOpacity(static_cast<uint8_t>(progress * (0xff / 2)));
+		} else {
+			animation.node->setPosition(value);
+			animation.node->setOpacity(static_cast<uint8_t>(progress * 0xff));
+		}
+
+		// Order does not matter, the last animation takes the finished one's place
+		if (progress < 1) i++;
+		else {
+			this->m_animations[i] = this->m_animations.back();
+			this->m_animations.pop_back();
+		}
+	}
+}
+
+bool dm::drawsAsGhost(ChunkedDeathStore const& deaths, size_t index) {
+	return settings.useGhostCube && deaths.ghost(index);
+}
+
+void MarkerPool::setLayers(CCSpriteBatchNode* markers, CCNode* ghosts) {
+	this->m_markerLayer = markers;
+	this->m_ghostLayer = ghosts;
+}
+
+void MarkerPool::reserve(size_t count) {
+	this->m_markers.reserve(this->m_markers.size() + count);
+	if (count <= this->m_freeMarkers.size()) return;
+
+	// Grow the batch once instead of repeatedly while adding
+	auto atlas = this->m_markerLayer->getTextureAtlas();
+	size_t needed = atlas->getTotalQuads() + count - this->m_freeMarkers.size();
+	if (needed > atlas->getCapacity()) atlas->resizeCapacity(needed);
+}
+
+CCNode* MarkerPool::acquire(ChunkedDeathStore const& deaths, size_t index,
+	bool isCurrent, bool preAnim) {
+
+	if (drawsAsGhost(deaths, index)) {
+		auto pose = deaths.ghost(index);
+		auto texture = this->ghostTexture(*pose);
+		CCSprite* node;
+		if (this->m_freeGhosts.empty()) {
+			node = CCSprite::createWithTexture(texture);
+			// Render textures come out upside down
+			node->setFlipY(true);
+			node->setAnchorPoint({ 0.5f, 0.5f });
+			this->m_ghostLayer->addChild(node);
+		} else {
+			node = this->m_freeGhosts.back();
+			this->m_freeGhosts.pop_back();
+			// All ghost textures have the same size, so the rect stays
+			if (node->getTexture() != texture) node->setTexture(texture);
+		}
+		placeGhostNode(node, deaths.pos(index), *pose, isCurrent, preAnim);
+		this->m_ghosts.push_back(node);
+		return node;
+	}
+
+	CCSprite* node;
+	if (this->m_freeMarkers.empty()) {
+		node = createMarkerNode(deaths.pos(index), isCurrent, preAnim);
+		this->m_markerLayer->addChild(node);
+	} else {
+		node = this->m_freeMarkers.back();
+		this->m_freeMarkers.pop_back();
+		placeMarkerNode(node, deaths.pos(index), isCurrent, preAnim);
+	}
+	this->m_markers.push_back(node);
+	return node;
+
+}
+
+CCNode* MarkerPool::acquireAnimated(ChunkedDeathStore const& deaths, size_t index,
+	bool isCurrent, double delay, double fadeTime) {
+
+	auto node = static_cast<CCSprite*>(this->acquire(deaths, index, isCurrent, true));
+	if (drawsAsGhost(deaths, index))
+		this->m_animator.addGhost(node, deaths.ghost(index)->isMini ? 0.6f : 1.0f,
+			delay, fadeTime);
+	else
+		this->m_animator.addMarker(node, deaths.pos(index), delay, fadeTime);
+	return node;
+
+}
+
+void MarkerPool::release(CCNode* node) {
+	this->m_animator.cancel(node);
+	node->setVisible(false);
+	// Order of nodes in use does not matter, swap the node to the back
+	if (node->getParent() == this->m_markerLayer) {
+		auto sprite = static_cast<CCSprite*>(node);
+		auto it = std::find(this->m_markers.rbegin(), this->m_markers.rend(), sprite);
+		std::swap(*it, this->m_markers.back());
+		this->m_markers.pop_back();
+		this->m_freeMarkers.push_back(sprite);
+	} else {
+		auto sprite = static_cast<CCSprite*>(node);
+		auto it = std::find(this->m_ghosts.rbegin(), this->m_ghosts.rend(), sprite);
+		std::swap(*it, this->m_ghosts.back());
+		this->m_ghosts.pop_back();
+		this->m_freeGhosts.push_back(sprite);
+	}
+}
+
+void MarkerPool::releaseAll() {
+	this->m_animator.clear();
+	for (auto node : this->m_markers) {
+		node->setVisible(false);
+		this->m_freeMarkers.push_back(node);
+	}
+	this->m_markers.clear();
+
+	for (auto node : this->m_ghosts) {
+		node->setVisible(false);
+		this->m_freeGhosts.push_back(node);
+	}
+	this->m_ghosts.clear();
+}
+
+CCTexture2D* MarkerPool::ghostTexture(GhostPose const& pose) {
+	auto& rendered = this->m_ghostTextures[ghostKey(pose)];
+	if (!rendered) rendered = renderGhost(pose);
+	return rendered->getSprite()->getTexture();
+}
 
+GhostPose dm::makeGhostPose(PlayerObject* player) {
+	GhostPose pose;
+	pose.isPlayer2 = player->m_isSecondPlayer;
+	pose.isMini = player->m_vehicleSize == 0.6f;
+	pose.isFlipped = player->m_isUpsideDown;
+	pose.isMirrored = player->m_isGoingLeft;
+	pose.rotation = player->m_fRotationX;
+
+	IconType mode;
+	if (player->m_isShip) {
+		mode = player->m_isPlatformer ? IconType::Jetpack : IconType::Ship;
+	} else if (player->m_isBall) {
+		mode = IconType::Ball;
+	} else if (player->m_isBird) {
+		mode = IconType::Ufo;
+	} else if (player->m_isDart) {
+		mode = IconType::Wave;
+	} else if (player->m_isRobot) {
+		mode = IconType::Robot;
+	} else if (player->m_isSpider) {
+		mode = IconType::Spider;
+	} else if (player->m_isSwing) {
+		mode = IconType::Swing;
+	} else {
+		mode = IconType::Cube;
+	}
+	pose.mode = static_cast<int>(mode);
+	return pose;
+}
 
-DeathLocationOut::DeathLocationOut(float x, float y) :
-	DeathLocationMin::DeathLocationMin(x, y) {
-	this->realTime = std::time(nullptr);
+bool dm::prefersHeatmap(size_t count) {
+	return settings.heatmapAbove > 0 &&
+		count > static_cast<size_t>(settings.heatmapAbove);
 }
 
-DeathLocationOut::DeathLocationOut(CCPoint pos) :
-	DeathLocationMin::DeathLocationMin(pos) {
-	this->realTime = std::time(nullptr);
+static CCNode* createHeatmapNode(DensityGrid const& grid,
+	std::vector<HeatmapTile> const& tiles) {
+
+	auto node = CCNode::create();
+	node->setID("heatmap"_spr);
+	for (auto const& tile : tiles) {
+		auto texture = new CCTexture2D();
+		texture->initWithData(tile.pixels.data(), kCCTexture2DPixelFormat_RGBA8888,
+			tile.width, tile.height, CCSize(tile.width, tile.height));
+		texture->autorelease();
+
+		// One pixel per cell, whatever the content scale factor
+		auto sprite = CCSprite::createWithTexture(texture);
+		sprite->setAnchorPoint({ 0, 0 });
+		sprite->setPosition({
+			grid.originX + tile.x * grid.cellSize,
+			grid.originY + tile.y * grid.cellSize
+		});
+		sprite->setScaleX(tile.width * grid.cellSize / sprite->getContentWidth());
+		sprite->setScaleY(tile.height * grid.cellSize / sprite->getContentHeight());
+		node->addChild(sprite);
+	}
+	return node;
+
 }
 
-void DeathLocationOut::addToJSON(matjson::Value* json) const {
-	json->set("x", matjson::Value(this->pos.x));
-	json->set("y", matjson::Value(this->pos.y));
-	json->set("percentage", matjson::Value(this->percentage));
-	json->set("practice", matjson::Value(this->practice));
+void dm::buildHeatmapNode(std::vector<float> xs, std::vector<float> ys,
+	std::function<void(CCNode*)> done) {
+
+	std::thread([xs = std::move(xs), ys = std::move(ys), done]() {
+		auto grid = std::make_shared<DensityGrid>(
+			binDeaths(xs, ys, HEATMAP_CELL_SIZE)
+		);
+		auto tiles = std::make_shared<std::vector<HeatmapTile>>(
+			rasterizeHeatmapTiles(*grid)
+		);
+		// Textures can only be created on the main thread
+		queueInMainThread([grid, tiles, done]() {
+			done(createHeatmapNode(*grid, *tiles));
+		});
+	}).detach();
+
+}
+
+
+void dm::addToJSON(DeathLocationOut const& death, matjson::Value* json) {
+	json->set("x", matjson::Value(death.pos.x));
+	json->set("y", matjson::Value(death.pos.y));
+	json->set("percentage", matjson::Value(death.percentage));
+	json->set("practice", matjson::Value(death.practice));
 	//json->set("coins", matjson::Value(this->coin1 | this->coin2 << 1 | this->coin3 << 2));
 	//json->set("itemdata", matjson::Value(this->itemdata));
 }
 
 
-DeathLocation::DeathLocation(float x, float y) :
-	DeathLocationMin::DeathLocationMin(x, y) {}
+DeathLocation::DeathLocation(float x, float y) {
+	this->pos = CCPoint(x, y);
+}
+
+DeathLocation::DeathLocation(CCPoint pos) {
+	this->pos = pos;
+}
 
-DeathLocation::DeathLocation(CCPoint pos) :
-	DeathLocationMin::DeathLocationMin(pos) {}
+DeathLocation::DeathLocation(AnalysisStore const& deaths, size_t index) {
+	this->pos = toCCPoint(deaths.pos(index));
+	this->percentage = deaths.percentage(index);
+	this->player = deaths.player(index);
+	this->levelVersion = deaths.levelVersion(index);
+	this->practice = deaths.practice(index);
+}
 
 CCSprite* DeathLocation::createNode() {
 	if (this->node) return this->node;
@@ -257,8 +455,7 @@ CCSprite* DeathLocation::createNode() {
 	this->updateNode();
 
 	std::string const id = "marker"_spr;
-	float markerScale = Mod::get()->getSettingValue<float>("marker-scale");
-	this->node->setScale(markerScale);
+	this->node->setScale(settings.markerScale);
 	this->node->setPosition(this->pos);
 	this->node->setAnchorPoint({ 0.5f, 0.0f });
 	return this->node;
@@ -270,14 +467,77 @@ void DeathLocation::updateNode() {
 }
 
 
+template <typename T>
+static void watchSetting(char const* key, std::function<void(T)> apply) {
+	apply(Mod::get()->getSettingValue<T>(key));
+	listenForSettingChanges<T>(key, apply);
+}
+
+static DrawCondition parseDrawCondition(std::string const& value) {
+	if (value == "Always") return DrawCondition::Always;
+	if (value == "Never") return DrawCondition::Never;
+	return DrawCondition::OnDeath;
+}
+
+void dm::watchSettings() {
+	watchSetting<bool>("share-deaths", [](bool value) {
+		settings.shareDeaths = value;
+	});
+	watchSetting<std::string>("store-local-2", [](std::string value) {
+		settings.storeLocal = value;
+	});
+	watchSetting<bool>("normal-only", [](bool value) {
+		settings.normalOnly = value;
+	});
+	watchSetting<std::string>("condition-normal", [](std::string value) {
+		settings.conditionNormal = parseDrawCondition(value);
+	});
+	watchSetting<std::string>("condition-practice", [](std::string value) {
+		settings.conditionPractice = parseDrawCondition(value);
+	});
+	watchSetting<bool>("newbest-only", [](bool value) {
+		settings.newbestOnly = value;
+	});
+	watchSetting<bool>("show-in-pause", [](bool value) {
+		settings.showInPause = value;
+	});
+	watchSetting<bool>("use-ghost-cube", [](bool value) {
+		settings.useGhostCube = value;
+	});
+	watchSetting<int64_t>("prog-bar-hist-height", [](int64_t value) {
+		settings.progBarHistHeight = static_cast<int>(value);
+	});
+	watchSetting<double>("marker-scale", [](double value) {
+		settings.markerScale = static_cast<float>(value);
+	});
+	watchSetting<double>("fade-time", [](double value) {
+		settings.fadeTime = static_cast<float>(value);
+	});
+	watchSetting<int64_t>("heatmap-above", [](int64_t value) {
+		settings.heatmapAbove = static_cast<int>(value);
+	});
+	watchSetting<bool>("stacks-in-editor", [](bool value) {
+		settings.stacksInEditor = value;
+	});
+	watchSetting<int64_t>("darken-editor", [](int64_t value) {
+		settings.darkenEditor = static_cast<int>(value);
+	});
+}
+
+bool dm::usesLocalDeaths(int stars) {
+	if (settings.storeLocal == "Always") return true;
+	if (settings.storeLocal == "Never") return false;
+	// Demons only
+	return stars >= 10;
+}
+
 bool dm::shouldSubmit(struct playingLevel& level, struct playerData& player) {
 	// Ignore Testmode and local Levels
 	if (level.testmode) return false;
 	if (level.levelId == 0) return false;
 
 	// Respect User Setting
-	auto sharingEnabled = Mod::get()->getSettingValue<bool>("share-deaths");
-	if (!sharingEnabled) return false;
+	if (!settings.shareDeaths) return false;
 
 	return true;
 };
@@ -326,18 +586,6 @@ std::string dm::makeRequestURL(char const* endpoint) {
 	return settValue + (endpoint[0] == '/' ? endpoint + 1 : endpoint);
 }
 
-std::string uint8_to_hex_string(const uint8_t *v, const size_t s) {
-  std::stringstream ss;
-
-  ss << std::hex << std::setfill('0');
-
-  for (int i = 0; i < s; i++) {
-    ss << std::hex << std::setw(2) << static_cast<int>(v[i]);
-  }
-
-  return ss.str();
-}
-
 ccColor3B dm::grayscale(ccColor3B const& color) {
 	auto brightness = static_cast<uint8_t>(color.r * GS_WEIGHT_RED +
 		color.r * GS_WEIGHT_RED + color.b * GS_WEIGHT_BLUE);
@@ -345,279 +593,166 @@ ccColor3B dm::grayscale(ccColor3B const& color) {
 };
 
 
-std::optional<unique_ptr<DeathLocationMin>> readCSVLine(
-	std::string const& buffer, bool hasPercentage) {
-	if (buffer.empty()) return std::nullopt;
+// Files belonging to a level, the CSV save of earlier versions has no extension
+static filesystem::path localDeathsPath(int levelId, char const* extension) {
+	return Mod::get()->getSaveDir() / (numToString(levelId) + extension);
+}
 
-	vector<std::string> coords = split(buffer, ',');
-	bool isGhost = coords.size() > 3;
-	int expect = (hasPercentage ? 3 : 2) + (isGhost * 3);
-	if (coords.size() != expect) {
-		log::warn(
-			"Error listing deaths: Unexpected number of elements: {} ({})",
-			coords, hasPercentage
-		);
-		return std::nullopt;
+LocalDeaths dm::getLocalDeaths(int levelId, bool csvHasPercentage) {
+	auto filePath = localDeathsPath(levelId, ".bin");
+	LocalDeaths result;
+	auto& deaths = result.deaths;
+	auto& baseCount = result.baseCount;
+
+	switch (readLocalDeaths(filePath, &deaths)) {
+		case LocalStatus::Ok:
+			baseCount = deaths.size();
+			break;
+		case LocalStatus::Corrupt:
+			log::warn("Local deaths at {} could not be read, ignoring them.",
+				filePath);
+			break;
+		case LocalStatus::Missing: {
+			auto csvPath = localDeathsPath(levelId, "");
+			if (!filesystem::exists(csvPath)) {
+				log::debug("No file found at {}.", filePath);
+				break;
+			}
+
+			// One-time migration, afterwards only the binary save is used
+			auto rejected = readLocalDeathsCSV(csvPath, csvHasPercentage, &deaths);
+			if (rejected)
+				log::warn("Skipped {} malformed lines listing local deaths.", rejected);
+			if (!writeLocalDeaths(filePath, deaths, true)) {
+				log::error("Could not migrate local deaths to {}.", filePath);
+				break;
+			}
+			baseCount = deaths.size();
+			std::error_code error;
+			filesystem::remove(csvPath, error);
+			log::info("Migrated {} local deaths from {} to {}.", deaths.size(),
+				csvPath, filePath);
+			break;
+		}
 	}
 
-	// Reserve variables, extract strings
-	float x;
-	float y;
-	int percent;
-	auto const& xStr = coords.at(0);
-	auto const& yStr = coords.at(1);
-
-	// Interpret Strings into Numbers
-	try {
-		x = stof(xStr);
-		y = stof(yStr);
-	} catch (invalid_argument) {
-		log::warn("Unexpected Non-Number coordinate listing deaths: {}", coords);
-		return std::nullopt;
-	}
+	// Deaths of previous sessions that were not compacted yet
+	auto journalPath = localDeathsPath(levelId, ".journal");
+	auto replayed = readJournal(journalPath, baseCount, &deaths);
+	if (replayed) log::debug("Replayed {} deaths from {}.", replayed, journalPath);
 
-	// If applicable, extract and interpret percentage
-	if (hasPercentage) {
-		auto const& percentStr = coords.at(isGhost ? 5 : 2);
-		try {
-			percent = stoi(percentStr);
-		} catch (invalid_argument) {
-			log::warn(
-				"Unexpected Non-Number coordinate listing deaths: {}",
-				coords
-			);
-			return std::nullopt;
+	if (shouldCompact(baseCount, replayed)) {
+		if (writeLocalDeaths(filePath, deaths, true)) {
+			log::debug("Compacted {} journaled deaths into {}.", replayed, filePath);
+			baseCount = deaths.size();
 		}
+		else log::error("Could not store local deaths at {}.", filePath);
 	}
 
-	if (isGhost) {
-		auto ghostLoc = make_unique<GhostLocation>(GhostLocation(x, y, percent));
-
-		float rotation;
-		IconType mode;
-		uint8_t flagField;
-		auto const& rotStr = coords.at(2);
-		auto const& modeStr = coords.at(3);
-		auto const& flagStr = coords.at(4);
-
-		try {
-			rotation = stof(rotStr);
-			mode = static_cast<IconType>(stof(modeStr));
-			flagField = stoi(flagStr);
-		} catch (invalid_argument) {
-			log::warn("Unexpected Non-Number coordinate listing deaths: {}", coords);
-			return std::nullopt;
-		}
-
-		ghostLoc->rotation = rotation;
-		ghostLoc->mode = mode;
-		ghostLoc->isPlayer2 = flagField & 1;
-		ghostLoc->isMini = flagField & 2;
-		ghostLoc->isFlipped = flagField & 4;
-		ghostLoc->isMirrored = flagField & 8;
-
-		return std::optional<unique_ptr<DeathLocationMin>>(std::move(ghostLoc));
-	} else {
-		auto deathLoc = make_unique<DeathLocationMin>(
-			DeathLocationMin(x, y, percent)
-		);
-
-		return std::optional<unique_ptr<DeathLocationMin>>(std::move(deathLoc));
-	}
+	return result;
 }
 
-vector<unique_ptr<DeathLocationMin>> dm::getLocalDeaths(int levelId, bool hasPercentage) {
-	filesystem::path filePath = Mod::get()->getSaveDir() / numToString(levelId);
-	vector<unique_ptr<DeathLocationMin>> deaths;
-	if (!filesystem::exists(filePath)) {
-		log::debug("No file found at {}.", filePath);
-		return deaths;
-	}
-
-	auto stream = ifstream(filePath);
-	std::string buffer;
-	char single;
-	while (stream.read(&single, 1)) {
-		if (single == '\n') {
-			// Process and clear buffer
-			auto deathLoc = readCSVLine(buffer, hasPercentage);
-			buffer = "";
-			if (!deathLoc.has_value()) continue;
-			deaths.push_back(std::move(*deathLoc));
-		} else buffer += single;
-	}
-	auto deathLoc = readCSVLine(buffer, hasPercentage);
-	if (deathLoc.has_value()) deaths.push_back(std::move(*deathLoc));
-	stream.close();
-	std::sort(
-		deaths.begin(),
-		deaths.end(),
-		LocationComparerPtr{}
-	);
-	return deaths;
+filesystem::path dm::listCachePath(int levelId, bool platformer,
+	bool inclPractice) {
+	auto dir = Mod::get()->getSaveDir() / "cache";
+	std::error_code error;
+	filesystem::create_directories(dir, error);
+	return dir / fmt::format("list-{}-{}-{}.bin", levelId,
+		platformer ? "platformer" : "normal", inclPractice ? "all" : "noprac");
 }
 
-void dm::storeLocalDeaths(int levelId,
-	vector<unique_ptr<DeathLocationMin>> const& deaths, bool hasPercentage) {
-	filesystem::path filePath = Mod::get()->getSaveDir() / numToString(levelId);
-
-	auto stream = ofstream(filePath);
-	for (auto& i : deaths) {
-		i->printCSV(stream, hasPercentage);
-		stream << endl;
-	}
-};
-
-
-void dm::parseBinDeathList(web::WebResponse* res,
-	vector<unique_ptr<DeathLocationMin>>* target, bool hasPercentage) {
-
-	auto const body = res->data();
-	int const elementWidth = 4 + 4 + (hasPercentage ? 2 : 0);
-	if (body.size() <= elementWidth) return;
-	uint8_t version = body[0];
-
-	int const deathCount = body.size() / elementWidth;
-	log::info(
-		"Got {} bytes of info, segment width {} (has percentage: {}) -> versioning byte {:#02x} + {} deaths",
-		body.size(), elementWidth, hasPercentage ? "y" : "n", version, deathCount
-	);
-	if (version != 1) {
-		log::warn("Unknown version {}! Skipping...", version);
-		return;
-	}
-	if ((body.size() - 1) % elementWidth) {
-		log::warn("{} excess bytes, probably data misalignment! Skipping...",
-			(body.size() - 1) % elementWidth);
-		return;
-	}
-	target->reserve(deathCount);
-
-	for (auto off = 1; off <= body.size() - elementWidth + 1; off += elementWidth) {
-#pragma pack(push, 1)
-		union stencil {
-			struct dmObj {
-				float x;
-				float y;
-				uint16_t perc;
-			} obj;
-			uint8_t raw[10];
-		} stencil{};
-#pragma pack(pop)
-
-		std::memcpy(stencil.raw, body.data() + off, elementWidth);
-
-		auto deathLoc = std::make_unique<DeathLocationMin>
-			(DeathLocationMin(stencil.obj.x, stencil.obj.y));
-		deathLoc->percentage = stencil.obj.perc;
-		target->push_back(std::move(deathLoc));
-	}
+bool dm::openLocalJournal(int levelId, size_t baseCount,
+	DeathJournal* journal) {
+	auto journalPath = localDeathsPath(levelId, ".journal");
+	if (journal->open(journalPath, baseCount)) return true;
+	log::error("Could not open {}, new deaths will not be saved.", journalPath);
+	return false;
+}
 
+void dm::runLocalIO(std::function<void()> task) {
+	static std::mutex mutex;
+	static std::deque<std::function<void()>> tasks;
+	// Whether a worker is draining tasks, it stops once they run out
+	static bool running = false;
+
+	std::lock_guard lock(mutex);
+	tasks.push_back(std::move(task));
+	if (running) return;
+	running = true;
+
+	std::thread([]() {
+		while (true) {
+			std::function<void()> next;
+			{
+				std::lock_guard lock(mutex);
+				if (tasks.empty()) {
+					running = false;
+					return;
+				}
+				next = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			next();
+		}
+	}).detach();
 }
 
-void dm::parseBinDeathList(web::WebResponse* res,
-	vector<DeathLocation>* target) {
 
-	auto const body = res->data();
-	int const elementWidth = 20 + 1 + 1 + 4 + 4 + 2;
-	if (body.size() <= elementWidth) return;
-	uint8_t version = body[0];
+// Logs the outcome of a binary decode, returns whether records were decoded
+static bool logParseResult(ParseResult const& result, size_t size) {
+	if (result.status == ParseStatus::TooShort) return false;
 
-	int const deathCount = body.size() / elementWidth;
 	log::info(
 		"Got {} bytes of info, segment width {} -> versioning byte {:#02x} + {} deaths",
-		body.size(), elementWidth, version, deathCount
+		size, result.elementWidth, result.version, result.count
 	);
-	if (version != 1) {
-		log::warn("Unknown version {}! Skipping...", version);
-		return;
+	if (result.status == ParseStatus::UnknownVersion) {
+		log::warn("Unknown version {}! Skipping...", result.version);
+		return false;
 	}
-	if ((body.size() - 1) % elementWidth) {
+	if (result.status == ParseStatus::Misaligned) {
 		log::warn("{} excess bytes, probably data misalignment! Skipping...",
-			(body.size() - 1) % elementWidth);
-		return;
+			result.excess);
+		return false;
 	}
-	target->reserve(deathCount);
-
-	for (auto off = 1; off <= body.size() - elementWidth + 1; off += elementWidth) {
-#pragma pack(push, 1)
-		union stencil {
-			struct dmObj {
-				uint8_t ident[20];
-				uint8_t levelversion;
-				uint8_t practice;
-				float x;
-				float y;
-				uint16_t perc;
-			} obj;
-			uint8_t raw[32];
-		} stencil{};
-#pragma pack(pop)
-
-		std::memcpy(stencil.raw, body.data() + off, elementWidth);
-
-		auto deathLoc = DeathLocation(stencil.obj.x, stencil.obj.y);
-		std::string userident = uint8_to_hex_string(stencil.obj.ident, 20);
-		deathLoc.userIdent = userident;
-		deathLoc.levelVersion = stencil.obj.levelversion;
-		deathLoc.practice = stencil.obj.practice != 0;
-		if (stencil.obj.practice > 1)
-			log::warn("Practice attribute = {:x}, probable data misalignment!",
-				stencil.obj.practice);
-		deathLoc.percentage = stencil.obj.perc;
-		target->push_back(deathLoc);
-	}
-
-}
-
-vector<std::string> dm::split(const std::string& string, const char at) {
-	auto result = vector<std::string>();
-	int currentStart = 0;
-
-	while (true) {
-		int nextSplit = string.find_first_of(at, currentStart);
-		if (nextSplit == std::string::npos) {
-			result.push_back(string.substr(
-				currentStart, string.size() - currentStart
-			));
-			return result;
-		}
-		int nextLength = nextSplit - currentStart;
-		result.push_back(string.substr(currentStart, nextLength));
-		currentStart = nextSplit + 1;
+	if (result.status == ParseStatus::Malformed) {
+		log::warn("Packed death list is malformed ({} bytes left over)! Skipping...",
+			result.excess);
+		return false;
 	}
+	if (result.invalidPractice)
+		log::warn("{} practice attributes > 1, probable data misalignment!",
+			result.invalidPractice);
+	return true;
 }
 
+bool dm::parseBinDeathList(web::WebResponse* res,
+	DeathStore* target, bool hasPercentage) {
 
-vector<unique_ptr<DeathLocationMin>>::iterator dm::binarySearchNearestXPosOnScreen(
-	vector<unique_ptr<DeathLocationMin>>::iterator from,
-	vector<unique_ptr<DeathLocationMin>>::iterator to, CCLayer* parent, float x,
-	bool preferHigher) {
-
-	if (to - from <= 1) return preferHigher ? to : from;
-
-	auto middle = from + ((to - from) / 2);
-
-	auto dist = parent->convertToWorldSpace((*middle)->pos).x;
-	if (dist > x) to = middle;
-	else from = middle;
-
-	return binarySearchNearestXPosOnScreen(from, to, parent, x, preferHigher);
+	auto const& body = res->data();
+	auto result = parseBinDeathList(ByteSpan(body), target, hasPercentage);
+	return logParseResult(result, body.size());
 
 }
 
-vector<unique_ptr<DeathLocationMin>>::iterator dm::binarySearchNearestXPos(
-	vector<unique_ptr<DeathLocationMin>>::iterator from,
-	vector<unique_ptr<DeathLocationMin>>::iterator to, float x,
-	bool preferHigher) {
+bool dm::parseBinDeathList(web::WebResponse* res, AnalysisStore* target) {
 
-	if (to - from <= 1) return preferHigher ? to : from;
+	auto const& body = res->data();
+	auto result = parseBinDeathList(ByteSpan(body), target);
+	return logParseResult(result, body.size());
 
-	auto middle = from + ((to - from) / 2);
+}
 
-	if ((*middle)->pos.x > x) to = middle;
-	else from = middle;
+std::optional<uint64_t> dm::cursorHeader(web::WebResponse* res,
+	std::string_view name) {
 
-	return binarySearchNearestXPos(from, to, x, preferHigher);
+	auto value = res->header(name);
+	if (!value) return std::nullopt;
+	uint64_t cursor;
+	auto result = std::from_chars(value->data(), value->data() + value->size(),
+		cursor);
+	if (result.ec != std::errc() || result.ptr != value->data() + value->size())
+		return std::nullopt;
+	return cursor;
 
-}
+}
\ No newline at end of file
@@ -1,7 +1,24 @@
 #pragma once
 #include <Geode/Geode.hpp>
 #include <Geode/utils/web.hpp>
+#include <cstdint>
 #include <ctime>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "core/model.hpp"
+#include "core/analysisStore.hpp"
+#include "core/binary.hpp"
+#include "core/chunkedStore.hpp"
+#include "core/deathStore.hpp"
+#include "core/heatmap.hpp"
+#include "core/histogram.hpp"
+#include "core/journal.hpp"
+#include "core/listCache.hpp"
+#include "core/local.hpp"
 
 using namespace geode::prelude;
 using namespace std;
@@ -16,6 +33,9 @@ namespace dm {
 	
 	constexpr int CURRENT_ZORDER = 2 << 29;
 	constexpr int OTHER_ZORDER = (2 << 29) - 1;
+	// Level space past the edge the player moves towards that gets markers
+	// ahead of time when drawing all markers
+	constexpr float WINDOW_LENIENCE = 120.0f;
 	constexpr float GS_WEIGHT_RED = 0.299;
 	constexpr float GS_WEIGHT_GREEN = 0.587;
 	constexpr float GS_WEIGHT_BLUE = 0.114;
@@ -33,72 +53,58 @@ namespace dm {
 		bool testmode = false;
 	};
 
-	// CLASSES
-
-	// Holds only information about a death location that the server sends for regular gameplay
-	class DeathLocationMin {
-	public:
-		CCPoint pos;
-		int percentage;
-
-		DeathLocationMin(float x, float y, int percentage);
-		DeathLocationMin(CCPoint pos, int percentage);
-		DeathLocationMin(float x, float y);
-		DeathLocationMin(CCPoint pos);
-
-		CCNode* createNode(bool isCurrent) const;
-		virtual CCNode* createAnimatedNode(bool isCurrent, double delay, double fadeTime) const;
-		virtual CCNode* createNode(bool isCurrent, bool preAnim) const;
-		virtual void printCSV(ostream& os, bool hasPercentage) const;
+	// SETTINGS
 
-		bool operator<(const DeathLocationMin& other) const;
+	enum class DrawCondition {
+		Never,
+		OnDeath,
+		Always
 	};
 
-	// Dynamic replacement for DeathLocationMin when using Ghost Cubes
-	// Stores additional needed information and overrides rendering
-	class GhostLocation : public DeathLocationMin {
-	public:
-		float rotation;
-		IconType mode;
-		bool isPlayer2;
-		bool isMini;
-		bool isFlipped;
-		bool isMirrored;
-		static inline bool shouldUse = false;
-
-		GhostLocation(PlayerObject* player);
-		GhostLocation(float x, float y);
-		GhostLocation(float x, float y, int percentage);
-		
-		CCNode* createAnimatedNode(bool isCurrent, double delay, double fadeTime)
-			const override;
-		CCNode* createNode(bool isCurrent, bool preAnim) const override;
-		void printCSV(ostream& os, bool hasPercentage) const override;
+	// Typed copy of the settings read while playing or editing, so those
+	// paths don't look them up by key. Kept current by watchSettings.
+	struct Settings {
+		bool shareDeaths = true;
+		std::string storeLocal = "Never";
+		bool normalOnly = false;
+		DrawCondition conditionNormal = DrawCondition::OnDeath;
+		DrawCondition conditionPractice = DrawCondition::Never;
+		bool newbestOnly = false;
+		bool showInPause = false;
+		bool useGhostCube = false;
+		int progBarHistHeight = 30;
+		float markerScale = 0.4f;
+		float fadeTime = 0.5f;
+		// 0 if heatmaps are never drawn
+		int heatmapAbove = 3000;
+		bool stacksInEditor = true;
+		int darkenEditor = 64;
 	};
 
-	// Holds all information about a death location that can be sent to the server
-	// Excludes info about the level, as it does not affect the death itself
-	class DeathLocationOut : public DeathLocationMin {
-	public:
-		/*
-		bool coin1 = false;
-		bool coin2 = false;
-		bool coin3 = false;
-		int itemdata = 0;
-		*/
-		bool practice = false;
-		std::time_t realTime = 0;
-		DeathLocationOut(float x, float y);
-		DeathLocationOut(CCPoint pos);
+	inline Settings settings;
+	// Reads all settings into settings and keeps it up to date on changes
+	void watchSettings();
+	// Whether a level with this star rating uses local deaths
+	bool usesLocalDeaths(int stars);
 
-		void addToJSON(matjson::Value* json) const;
-	};
+	inline CCPoint toCCPoint(Vec2 const& pos) {
+		return CCPoint(pos.x, pos.y);
+	}
+
+	inline Vec2 toVec2(CCPoint const& pos) {
+		return { pos.x, pos.y };
+	}
+
+	// CLASSES
 
 	// Holds all information about a death location that the server sends for analysis
 	// Includes info about the level, because the server sends it for each individual death
-	class DeathLocation : public DeathLocationMin {
+	class DeathLocation {
 	public:
-		std::string userIdent;
+		CCPoint pos;
+		int percentage = 0;
+		// Interned index of the player, see AnalysisStore::player
+		uint32_t player = 0;
 		int levelVersion = 1;
 		bool practice = false;
 		bool clustered = false;
@@ -112,52 +118,155 @@ namespace dm {
 
 		DeathLocation(float x, float y);
 		DeathLocation(CCPoint pos);
+		DeathLocation(AnalysisStore const& deaths, size_t index);
 
 		CCSprite* createNode();
 		void updateNode();
 	};
 
 	struct LocationComparer {
-    bool operator()(const DeathLocationMin& a,
-                    const DeathLocationMin& b) const {
+    bool operator()(const DeathLocation& a,
+                    const DeathLocation& b) const {
         return a.pos.x < b.pos.x;
     }
 	};
 
-	struct LocationComparerPtr {
-    bool operator()(const std::unique_ptr<DeathLocationMin>& a,
-                    const std::unique_ptr<DeathLocationMin>& b) const {
-        return a->pos.x < b->pos.x;
-    }
+	// MARKERS
+
+	// Whether the death is drawn as a ghost cube rather than a marker sprite.
+	// Marker sprites all share the death-marker.png texture, so they can be
+	// added to one CCSpriteBatchNode.
+	bool drawsAsGhost(ChunkedDeathStore const& deaths, size_t index);
+	// Fades in markers and ghost cubes from one loop per frame, instead of a
+	// sequence of actions per node for the action manager to tick
+	class MarkerAnimator {
+	public:
+		// Drops from where the node is to pos while fading in
+		void addMarker(CCSprite* node, Vec2 pos, float delay, float duration);
+		// Grows from the node's scale to scale while fading in to half opacity
+		void addGhost(CCSprite* node, float scale, float delay, float duration);
+		// Stops animating the node, leaving it as it is
+		void cancel(CCNode* node);
+		void clear();
+		// Advances all animations by dt seconds, finished ones are dropped
+		void update(float dt);
+
+	private:
+		struct Animation {
+			CCSprite* node;
+			float start;
+			float duration;
+			bool isGhost;
+			// Position for markers, scale in x for ghost cubes
+			CCPoint from;
+			CCPoint to;
+		};
+
+		std::vector<Animation> m_animations;
+		// Seconds advanced so far
+		float m_time = 0;
 	};
 
+	// Keeps the nodes of markers and ghost cubes once created. Released nodes
+	// are hidden and handed out again for the next deaths to draw, so drawing
+	// the same deaths again after a reset creates no nodes.
+	class MarkerPool {
+	public:
+		// Layers new nodes are added to, see drawsAsGhost
+		void setLayers(CCSpriteBatchNode* markers, CCNode* ghosts);
+		// Makes room for count more nodes to be acquired
+		void reserve(size_t count);
+
+		// Returns a node for a death in the store, either a marker or a ghost
+		// cube, already added to its layer. Animated ones start out hidden and
+		// fade in after delay, driven by animate.
+		CCNode* acquire(ChunkedDeathStore const& deaths, size_t index, bool isCurrent,
+			bool preAnim = false);
+		CCNode* acquireAnimated(ChunkedDeathStore const& deaths, size_t index,
+			bool isCurrent, double delay, double fadeTime);
+		// Hides a node in use and makes it available again
+		void release(CCNode* node);
+		void releaseAll();
+		// Advances the fade in of animated nodes, call once per frame
+		void animate(float dt) { this->m_animator.update(dt); }
+
+		// Nodes in use
+		std::span<CCSprite* const> markers() const { return this->m_markers; }
+		std::span<CCSprite* const> ghosts() const { return this->m_ghosts; }
+
+	private:
+		// Nodes stay children of their layer, which keeps them alive
+		CCSpriteBatchNode* m_markerLayer = nullptr;
+		CCNode* m_ghostLayer = nullptr;
+		std::vector<CCSprite*> m_markers;
+		std::vector<CCSprite*> m_ghosts;
+		std::vector<CCSprite*> m_freeMarkers;
+		std::vector<CCSprite*> m_freeGhosts;
+		MarkerAnimator m_animator;
+		// Player icon rendered once per icon mode and player, ghost cubes
+		// are sprites of these. Icons can't change while playing, a pool
+		// lives as long as its level.
+		std::unordered_map<int, Ref<CCRenderTexture>> m_ghostTextures;
+
+		CCTexture2D* ghostTexture(GhostPose const& pose);
+	};
+
+	GhostPose makeGhostPose(PlayerObject* player);
+
+	// Width of the attempt time chart at the top of the screen in platformer
+	// levels, about that of the progress bar in normal levels
+	constexpr float PLATFORMER_CHART_WIDTH = 200;
+
+	// HEATMAP
+
+	// Level units covered by a heatmap cell, half a block
+	constexpr float HEATMAP_CELL_SIZE = 15;
+
+	// Whether this many deaths are drawn as a heatmap, see "heatmap-above"
+	bool prefersHeatmap(size_t count);
+	// Bins and rasterizes deaths on a worker thread, then calls done on the
+	// main thread with a node of heatmap tiles in level coordinates
+	void buildHeatmapNode(std::vector<float> xs, std::vector<float> ys,
+		std::function<void(CCNode*)> done);
+
 	bool shouldSubmit(struct playingLevel& level, struct playerData& player);
 	bool willEverDraw(struct playingLevel& level);
 
+	void addToJSON(DeathLocationOut const& death, matjson::Value* json);
+
 	std::string makeRequestURL(char const* endpoint);
 	ccColor3B grayscale(ccColor3B const& color);
 
-	vector<unique_ptr<DeathLocationMin>> getLocalDeaths(int levelId,
-		bool hasPercentage);
-	void storeLocalDeaths(int levelId,
-		vector<unique_ptr<DeathLocationMin>> const& deaths, bool hasPercentage);
-
-	void parseBinDeathList(web::WebResponse* res,
-		vector<unique_ptr<DeathLocationMin>>* target, bool hasPercentage);
-	void parseBinDeathList(web::WebResponse* res,
-		vector<DeathLocation>* target);
+	// Deaths of a level as stored locally
+	struct LocalDeaths {
+		DeathStore deaths;
+		// Number of deaths in the save itself, the journal builds on top of it
+		size_t baseCount = 0;
+	};
 
-	vector<std::string> split(const std::string& string, const char at);
+	// Loads the save and journal of a level. Only touches files, so it can
+	// run on a worker thread. Saves are always written with percentages,
+	// csvHasPercentage only tells how to read a CSV save of earlier versions.
+	LocalDeaths getLocalDeaths(int levelId, bool csvHasPercentage);
+	// Where the /list response for these parameters is cached
+	std::filesystem::path listCachePath(int levelId, bool platformer,
+		bool inclPractice);
 
-	vector<unique_ptr<DeathLocationMin>>::iterator binarySearchNearestXPosOnScreen(
-		vector<unique_ptr<DeathLocationMin>>::iterator from,
-		vector<unique_ptr<DeathLocationMin>>::iterator to, CCLayer* parent, float x,
-		bool preferHigher);
+	// Opens the journal to record further deaths of a level in
+	bool openLocalJournal(int levelId, size_t baseCount, DeathJournal* journal);
+	// Runs task on a worker thread after all tasks queued before it. Loading,
+	// compacting and journaling local deaths all go through here, so they
+	// never overlap, even if a level is entered again before the last load
+	// of it finished.
+	void runLocalIO(std::function<void()> task);
 
-	vector<unique_ptr<DeathLocationMin>>::iterator binarySearchNearestXPos(
-		vector<unique_ptr<DeathLocationMin>>::iterator from,
-		vector<unique_ptr<DeathLocationMin>>::iterator to, float x,
-		bool preferHigher);
+	// Returns whether the response could be used
+	bool parseBinDeathList(web::WebResponse* res,
+		DeathStore* target, bool hasPercentage);
+	bool parseBinDeathList(web::WebResponse* res, AnalysisStore* target);
+	// Numeric value of a response header such as X-Death-Cursor
+	std::optional<uint64_t> cursorHeader(web::WebResponse* res,
+		std::string_view name);
 
 }
 
@@ -74,45 +74,3 @@ void Submitter::submit() {
 	this->listener.setFilter(this->request.get(dm::makeRequestURL("submit")));
 }
 
-
-void dm::purgeSpam(vector<DeathLocationOut>& deaths) {
-	int total = deaths.size();
-
-	if (total < 10) return;
-	log::debug("Spam Removal: 10 death threshold passed.");
-
-	std::time_t timeDiff = deaths.back().realTime - deaths.front().realTime;
-	log::debug("Spam Removal: {} deaths over {} seconds.", total, timeDiff);
-	// Limit to 1 death per 1.5 seconds
-	if (timeDiff * 2 < static_cast<long long>(total) * 3) {
-		deaths.clear();
-		return;
-	}
-	log::debug("Spam Removal: Time check passed.");
-
-	if (total < 20) return;
-	log::debug("Spam Removal: 20 death threshold passed.");
-
-	unordered_map<int, uint32_t> xFrequency;
-	for (auto i = deaths.begin(); i < deaths.end(); i++) {
-		int translatedX = translate ( i->pos.x );
-		if (xFrequency.contains(translatedX)) xFrequency[translatedX] = 0;
-		xFrequency[translatedX]++;
-	}
-
-	uint32_t max = 0;
-	for (auto& [x, count] : xFrequency) {
-		if (count > max) max = count;
-	}
-	log::debug("Spam Removal: Maximum concentration {}", max);
-
-	if (max * max / 2 < total) return;
-	log::debug("Spam Removal: Square Threshold passed.");
-
-	log::debug("Spam Removal: Pre-purge {}", total);
-	erase_if(deaths, [&xFrequency, max](auto& d){
-		int translatedX = translate ( d.pos.x );
-		return static_cast<float>(xFrequency[translatedX]) / max > .8;
-	});
-	log::debug("Spam Removal: Post-purge {}", deaths.size());
-}
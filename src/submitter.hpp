@@ -6,8 +6,6 @@
 #include <thread>
 #include "shared.hpp"
 
-#define translate( X ) static_cast<int>(X / 30)
-
 int const MAX_RETRIES = 8;
 auto const RETRY_TIMEOUT = std::chrono::seconds(15);
 // = 120 Seconds = 2 Minutes of retrying
@@ -25,8 +23,4 @@ public:
   Submitter(web::WebRequest request);
 	~Submitter();
   void submit();
-};
-
-namespace dm {
-  void purgeSpam(vector<DeathLocationOut>& deaths);
-}
\ No newline at end of file
+};
\ No newline at end of file
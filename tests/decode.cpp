@@ -0,0 +1,309 @@
+#include <cstring>
+#include "tests.hpp"
+#include "core/binary.hpp"
+#include "core/bulkDecode.hpp"
+#include "core/packedList.hpp"
+
+using namespace dm;
+
+namespace {
+
+	std::vector<uint8_t> makeListBody(std::vector<Vec2> const& positions,
+		bool hasPercentage) {
+		size_t const elementWidth = hasPercentage ? 10 : 8;
+		std::vector<uint8_t> body(1 + positions.size() * elementWidth);
+		body[0] = 1;
+		for (size_t i = 0; i < positions.size(); i++) {
+			uint8_t* record = body.data() + 1 + i * elementWidth;
+			uint16_t percentage = static_cast<uint16_t>(i % 101);
+			std::memcpy(record, &positions[i].x, 4);
+			std::memcpy(record + 4, &positions[i].y, 4);
+			if (hasPercentage) std::memcpy(record + 8, &percentage, 2);
+		}
+		return body;
+	}
+
+	// Player i has an ident of 20 times the byte i % 7
+	std::vector<uint8_t> makeAnalysisBody(std::vector<Vec2> const& positions) {
+		std::vector<uint8_t> body(1 + positions.size() * analysisElementWidth);
+		body[0] = 1;
+		for (size_t i = 0; i < positions.size(); i++) {
+			uint8_t* record = body.data() + 1 + i * analysisElementWidth;
+			uint16_t percentage = static_cast<uint16_t>(i % 101);
+			std::memset(record, static_cast<int>(i % 7), 20);
+			record[20] = static_cast<uint8_t>(i % 3);
+			record[21] = i % 5 == 0 ? 2 : i % 2;
+			std::memcpy(record + 22, &positions[i].x, 4);
+			std::memcpy(record + 26, &positions[i].y, 4);
+			std::memcpy(record + 30, &percentage, 2);
+		}
+		return body;
+	}
+
+	std::vector<uint8_t> makeAnalysisDictionaryBody(
+		std::vector<Vec2> const& positions, uint32_t players) {
+		size_t const recordStart = 5 + players * AnalysisStore::identWidth;
+		std::vector<uint8_t> body(recordStart +
+			positions.size() * analysisDictionaryElementWidth);
+		body[0] = analysisDictionaryVersion;
+		std::memcpy(body.data() + 1, &players, 4);
+		for (uint32_t player = 0; player < players; player++)
+			std::memset(body.data() + 5 + player * AnalysisStore::identWidth,
+				static_cast<int>(player), AnalysisStore::identWidth);
+
+		for (size_t i = 0; i < positions.size(); i++) {
+			uint8_t* record = body.data() + recordStart +
+				i * analysisDictionaryElementWidth;
+			uint32_t player = static_cast<uint32_t>(i % players);
+			uint16_t percentage = static_cast<uint16_t>(i % 101);
+			std::memcpy(record, &player, 4);
+			record[4] = 1;
+			record[5] = i % 2;
+			std::memcpy(record + 6, &percentage, 2);
+			std::memcpy(record + 8, &positions[i].x, 4);
+			std::memcpy(record + 12, &positions[i].y, 4);
+		}
+		return body;
+	}
+
+	void testList() {
+		auto const positions = test::makePositions(1003);
+		for (bool hasPercentage : { false, true }) {
+			auto body = makeListBody(positions, hasPercentage);
+
+			DeathStore deaths;
+			auto result = parseBinDeathList(body, &deaths, hasPercentage);
+			CHECK(result.status == ParseStatus::Ok);
+			CHECK(deaths.size() == positions.size());
+			for (size_t i = 0; i < positions.size(); i++) {
+				CHECK(deaths.x(i) == positions[i].x);
+				CHECK(deaths.y(i) == positions[i].y);
+				if (hasPercentage) CHECK(deaths.percentage(i) == static_cast<int>(i % 101));
+			}
+
+			// A cut off record invalidates the whole response
+			body.pop_back();
+			DeathStore misaligned;
+			misaligned.push_back({ 1, 2 }, 3);
+			result = parseBinDeathList(body, &misaligned, hasPercentage);
+			CHECK(result.status == ParseStatus::Misaligned);
+			CHECK(misaligned.size() == 1);
+
+			body.resize(4);
+			DeathStore truncated;
+			result = parseBinDeathList(body, &truncated, hasPercentage);
+			CHECK(result.status == ParseStatus::TooShort);
+			CHECK(truncated.empty());
+		}
+
+		std::vector<uint8_t> unknown = makeListBody(positions, true);
+		unknown[0] = 7;
+		DeathStore deaths;
+		CHECK(parseBinDeathList(unknown, &deaths, true).status ==
+			ParseStatus::UnknownVersion);
+	}
+
+	void testPackedList() {
+		auto const positions = test::makePositions(1000);
+		DeathStore source;
+		for (size_t i = 0; i < positions.size(); i++)
+			source.push_back(positions[i], static_cast<int>(i % 101));
+		source.sortByX();
+
+		uint32_t const scale = 4;
+		for (bool hasPercentage : { false, true }) {
+			auto body = encodePackedList(source, hasPercentage, scale);
+
+			DeathStore deaths;
+			auto result = parseBinDeathList(body, &deaths, hasPercentage);
+			CHECK(result.status == ParseStatus::Ok);
+			CHECK(deaths.size() == source.size());
+			for (size_t i = 0; i < deaths.size() && i < source.size(); i++) {
+				// Quantized to a quarter unit
+				CHECK(std::abs(deaths.x(i) - source.x(i)) <= 0.5f / scale);
+				CHECK(std::abs(deaths.y(i) - source.y(i)) <= 0.5f / scale);
+				if (hasPercentage) CHECK(deaths.percentage(i) == source.percentage(i));
+			}
+
+			// Cut off in the middle of a block
+			body.resize(body.size() - 20);
+			DeathStore truncated;
+			truncated.push_back({ 1, 2 }, 3);
+			result = parseBinDeathList(body, &truncated, hasPercentage);
+			CHECK(result.status == ParseStatus::Malformed);
+			CHECK(truncated.size() == 1);
+		}
+
+		// A header announcing far more deaths than the body can hold must
+		// fail instead of reserving space for them
+		std::vector<uint8_t> hostile = { packedListVersion, 1, 4 };
+		for (int i = 0; i < 9; i++) hostile.push_back(0xff);
+		hostile.insert(hostile.end(), { 0x01, 0, 8, 8, 8 });
+		DeathStore deaths;
+		auto result = parseBinDeathList(hostile, &deaths, true);
+		CHECK(result.status == ParseStatus::Malformed);
+		CHECK(deaths.empty());
+
+		// Same without a known size, the deaths are never reserved at all
+		BinListDecoder decoder(&deaths, true);
+		decoder.feed(hostile);
+		CHECK(decoder.finish().status == ParseStatus::Malformed);
+		CHECK(deaths.empty());
+	}
+
+	// Column widths from a few bits up to beyond what the AVX2 kernel takes,
+	// and a count that leaves a partial block and group
+	void testPackedKernels() {
+		auto const positions = test::makePositions(1003);
+		auto const original = getDecodeKernel();
+		for (float spread : { 1.f, 100.f, 1e4f }) {
+			DeathStore source;
+			for (size_t i = 0; i < positions.size(); i++) {
+				source.push_back({ positions[i].x, positions[i].y * spread },
+					static_cast<int>(i % 101));
+			}
+			source.sortByX();
+
+			for (uint32_t scale : { 1u, 16u, 256u }) {
+				auto const body = encodePackedList(source, true, scale);
+				std::vector<DeathStore> decoded;
+				for (auto kernel : { DecodeKernel::Scalar, DecodeKernel::AVX2 }) {
+					setDecodeKernel(kernel);
+					CHECK(parseBinDeathList(body, &decoded.emplace_back(), true).status ==
+						ParseStatus::Ok);
+				}
+				CHECK(decoded[1].size() == decoded[0].size());
+				for (size_t i = 0; i < decoded[0].size() && i < decoded[1].size(); i++) {
+					CHECK(decoded[1].x(i) == decoded[0].x(i));
+					CHECK(decoded[1].y(i) == decoded[0].y(i));
+					CHECK(decoded[1].percentage(i) == decoded[0].percentage(i));
+				}
+			}
+		}
+		setDecodeKernel(original);
+	}
+
+	void checkAnalysis(AnalysisStore const& deaths, std::vector<Vec2> const& positions,
+		size_t start) {
+		for (size_t i = 0; i < positions.size(); i++) {
+			CHECK(deaths.x(start + i) == positions[i].x);
+			CHECK(deaths.y(start + i) == positions[i].y);
+			CHECK(deaths.percentage(start + i) == static_cast<int>(i % 101));
+		}
+	}
+
+	void testAnalysis() {
+		auto const positions = test::makePositions(1001);
+		auto body = makeAnalysisBody(positions);
+
+		AnalysisStore deaths;
+		auto result = parseBinDeathList(body, &deaths);
+		CHECK(result.status == ParseStatus::Ok);
+		CHECK(deaths.size() == positions.size());
+		CHECK(deaths.playerCount() == 7);
+		CHECK(result.invalidPractice == (positions.size() + 4) / 5);
+		checkAnalysis(deaths, positions, 0);
+		for (size_t i = 0; i < deaths.size(); i++)
+			CHECK(deaths.ident(i)[0] == i % 7);
+
+		body.push_back(0);
+		AnalysisStore misaligned;
+		CHECK(parseBinDeathList(body, &misaligned).status == ParseStatus::Misaligned);
+		CHECK(misaligned.empty());
+
+		// Version 2 interns the same players again
+		auto dictionary = makeAnalysisDictionaryBody(positions, 7);
+		result = parseBinDeathList(dictionary, &deaths);
+		CHECK(result.status == ParseStatus::Ok);
+		CHECK(deaths.size() == positions.size() * 2);
+		CHECK(deaths.playerCount() == 7);
+		checkAnalysis(deaths, positions, positions.size());
+		for (size_t i = 0; i < positions.size(); i++)
+			CHECK(deaths.ident(positions.size() + i)[0] == i % 7);
+
+		dictionary.push_back(0);
+		AnalysisStore dictionaryMisaligned;
+		CHECK(parseBinDeathList(dictionary, &dictionaryMisaligned).status ==
+			ParseStatus::Misaligned);
+		CHECK(dictionaryMisaligned.empty());
+		CHECK(dictionaryMisaligned.playerCount() == 0);
+
+		// More players announced than the body holds
+		dictionary.resize(5 + 3 * AnalysisStore::identWidth);
+		AnalysisStore truncated;
+		CHECK(parseBinDeathList(dictionary, &truncated).status == ParseStatus::TooShort);
+		CHECK(truncated.empty());
+
+		// A player count whose ident table would not fit in memory
+		uint32_t const huge = 0xffffffff;
+		std::memcpy(dictionary.data() + 1, &huge, 4);
+		CHECK(parseBinDeathList(dictionary, &truncated).status == ParseStatus::TooShort);
+		CHECK(truncated.empty());
+
+		// Players past the announced ones
+		auto badPlayer = makeAnalysisDictionaryBody(positions, 7);
+		uint32_t const player = 7;
+		std::memcpy(badPlayer.data() + 5 + 7 * AnalysisStore::identWidth, &player, 4);
+		AnalysisStore malformed;
+		CHECK(parseBinDeathList(badPlayer, &malformed).status == ParseStatus::Malformed);
+		CHECK(malformed.empty());
+		CHECK(malformed.playerCount() == 0);
+
+		// A failed parse leaves nothing for the next one to build on
+		auto valid = makeAnalysisDictionaryBody(positions, 5);
+		CHECK(parseBinDeathList(valid, &malformed).status == ParseStatus::Ok);
+		CHECK(malformed.playerCount() == 5);
+		for (size_t i = 0; i < positions.size(); i++)
+			CHECK(malformed.ident(i)[0] == i % 5);
+	}
+
+	void testKernels() {
+		auto const positions = test::makePositions(1027);
+		auto const list = makeListBody(positions, true);
+		auto const analysis = makeAnalysisBody(positions);
+		auto const original = getDecodeKernel();
+
+		std::vector<DeathStore> lists;
+		std::vector<AnalysisStore> analyses;
+		std::vector<std::vector<uint8_t>> idents;
+		std::vector<size_t> invalidPractice;
+		for (auto kernel : { DecodeKernel::Scalar, DecodeKernel::SSE2, DecodeKernel::AVX2 }) {
+			setDecodeKernel(kernel);
+
+			auto& deaths = lists.emplace_back();
+			decodeListRecords(list.data() + 1, positions.size(), 10,
+				deaths.extend(positions.size()));
+
+			auto& records = analyses.emplace_back();
+			auto& ident = idents.emplace_back(positions.size() * AnalysisStore::identWidth);
+			invalidPractice.push_back(decodeAnalysisRecords(analysis.data() + 1,
+				positions.size(), records.extend(positions.size()), ident.data()));
+		}
+		setDecodeKernel(original);
+
+		// Kernels the CPU lacks fall back, so at worst this compares one to itself
+		for (size_t k = 1; k < lists.size(); k++) {
+			for (size_t i = 0; i < positions.size(); i++) {
+				CHECK(lists[k].x(i) == lists[0].x(i));
+				CHECK(lists[k].y(i) == lists[0].y(i));
+				CHECK(lists[k].percentage(i) == lists[0].percentage(i));
+				CHECK(analyses[k].x(i) == analyses[0].x(i));
+				CHECK(analyses[k].y(i) == analyses[0].y(i));
+				CHECK(analyses[k].percentage(i) == analyses[0].percentage(i));
+				CHECK(analyses[k].levelVersion(i) == analyses[0].levelVersion(i));
+				CHECK(analyses[k].practice(i) == analyses[0].practice(i));
+			}
+			CHECK(idents[k] == idents[0]);
+			CHECK(invalidPractice[k] == invalidPractice[0]);
+		}
+	}
+
+}
+
+void test::testDecode() {
+	testList();
+	testPackedList();
+	testPackedKernels();
+	testAnalysis();
+	testKernels();
+}
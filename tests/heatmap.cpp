@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstring>
+#include "tests.hpp"
+#include "core/heatmap.hpp"
+
+using namespace dm;
+
+namespace {
+
+	void testBinning() {
+		auto const positions = test::makePositions(20000);
+		std::vector<float> xs, ys;
+		for (auto const& pos : positions) {
+			xs.push_back(pos.x);
+			ys.push_back(pos.y);
+		}
+
+		auto const grid = binDeaths(xs, ys, 15);
+		CHECK(grid.cellSize == 15);
+		CHECK(grid.width <= 2048);
+		CHECK(grid.height <= 2048);
+
+		// Counted one death at a time
+		std::vector<uint32_t> counts(static_cast<size_t>(grid.width) * grid.height);
+		for (auto const& pos : positions) {
+			int x = std::min(grid.width - 1,
+				static_cast<int>((pos.x - grid.originX) * (1 / grid.cellSize)));
+			int y = std::min(grid.height - 1,
+				static_cast<int>((pos.y - grid.originY) * (1 / grid.cellSize)));
+			counts[y * grid.width + x]++;
+		}
+		CHECK(grid.counts == counts);
+		CHECK(grid.maxCount == *std::max_element(counts.begin(), counts.end()));
+
+		// Deaths far apart grow the cells instead of the grid
+		std::vector<float> farXs = { -1e7f, 0, 1e7f };
+		std::vector<float> farYs = { 0, 5e6f, 1e7f };
+		auto const far = binDeaths(farXs, farYs, 1);
+		CHECK(far.width <= 2048);
+		CHECK(far.height <= 2048);
+		CHECK(far.at(0, 0) == 1);
+		CHECK(far.at(far.width - 1, far.height - 1) == 1);
+
+		CHECK(binDeaths({}, {}, 15).counts.empty());
+	}
+
+	void testRasterizing() {
+		DensityGrid grid;
+		grid.width = 300;
+		grid.height = 70;
+		for (int i = 0; i < grid.width * grid.height; i++)
+			grid.counts.push_back(i % 3 == 0 ? 0 : static_cast<uint32_t>(i % 1000));
+		grid.maxCount = 999;
+
+		std::vector<uint8_t> whole(static_cast<size_t>(grid.width) * grid.height * 4);
+		rasterizeHeatmap(grid, 0, 0, grid.width, grid.height, whole.data());
+
+		// Empty cells are transparent, the fullest one opaque red
+		CHECK(whole[(grid.height - 1) * grid.width * 4 + 3] == 0);
+		// Cell 1999 at (199, 6), in row 63 from the top
+		size_t const full = (63 * grid.width + 199) * 4;
+		CHECK(std::memcmp(&whole[full], "\xff\x00\x00\xff", 4) == 0);
+
+		// Tiles hold the same pixels as rasterizing the grid at once
+		auto const tiles = rasterizeHeatmapTiles(grid, 64);
+		CHECK(tiles.size() == 5 * 2);
+		size_t pixels = 0;
+		for (auto const& tile : tiles) {
+			CHECK(tile.width <= 64);
+			CHECK(tile.height <= 64);
+			pixels += tile.pixels.size() / 4;
+			for (int row = 0; row < tile.height; row++) {
+				// Both are written top down
+				int const y = grid.height - 1 - (tile.y + tile.height - 1 - row);
+				CHECK(std::memcmp(tile.pixels.data() + row * tile.width * 4,
+					whole.data() + (static_cast<size_t>(y) * grid.width + tile.x) * 4,
+					static_cast<size_t>(tile.width) * 4) == 0);
+			}
+		}
+		CHECK(pixels == grid.counts.size());
+	}
+
+}
+
+void test::testHeatmap() {
+	testBinning();
+	testRasterizing();
+}
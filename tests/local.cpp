@@ -0,0 +1,125 @@
+#include <filesystem>
+#include "tests.hpp"
+#include "core/histogram.hpp"
+#include "core/journal.hpp"
+#include "core/local.hpp"
+
+using namespace dm;
+
+namespace {
+
+	std::filesystem::path tempDirectory() {
+		auto directory = std::filesystem::temp_directory_path() /
+			"DeathMarkersTests";
+		std::filesystem::create_directories(directory);
+		return directory;
+	}
+
+	DeathStore makeDeaths(size_t count) {
+		auto positions = test::makePositions(count);
+		DeathStore deaths;
+		for (size_t i = 0; i < count; i++) {
+			DeathEntry entry{ positions[i], static_cast<int>(i % 101), std::nullopt };
+			if (i % 4 == 0) {
+				entry.ghost = GhostPose{ static_cast<float>(i), 3 };
+				entry.ghost->setFlags(static_cast<uint8_t>(i % 16));
+			}
+			deaths.push_back(entry);
+		}
+		deaths.sortByX();
+		return deaths;
+	}
+
+	void checkSame(DeathStore const& a, DeathStore const& b, bool hasPercentage) {
+		CHECK(a.size() == b.size());
+		for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+			CHECK(a.pos(i) == b.pos(i));
+			if (hasPercentage) CHECK(a.percentage(i) == b.percentage(i));
+			CHECK((a.ghost(i) == nullptr) == (b.ghost(i) == nullptr));
+			if (a.ghost(i) && b.ghost(i)) {
+				CHECK(a.ghost(i)->rotation == b.ghost(i)->rotation);
+				CHECK(a.ghost(i)->mode == b.ghost(i)->mode);
+				CHECK(a.ghost(i)->flagField() == b.ghost(i)->flagField());
+			}
+		}
+	}
+
+	void testSave(std::filesystem::path const& directory) {
+		auto const path = directory / "save.bin";
+		auto const deaths = makeDeaths(3000);
+
+		for (bool hasPercentage : { false, true }) {
+			CHECK(writeLocalDeaths(path, deaths, hasPercentage));
+			DeathStore read;
+			CHECK(readLocalDeaths(path, &read) == LocalStatus::Ok);
+			checkSame(read, deaths, hasPercentage);
+		}
+
+		DeathStore missing;
+		CHECK(readLocalDeaths(directory / "missing.bin", &missing) ==
+			LocalStatus::Missing);
+		CHECK(missing.empty());
+	}
+
+	// Platformer saves of earlier versions and their CSV lines have no times,
+	// which must not end up in the first column of the chart
+	void testUntimed(std::filesystem::path const& directory) {
+		auto const path = directory / "untimed.bin";
+		CHECK(writeLocalDeaths(path, makeDeaths(100), false));
+		DeathStore read;
+		CHECK(readLocalDeaths(path, &read) == LocalStatus::Ok);
+		auto line = readCSVLine("12.5,40", false);
+		CHECK(line.has_value() && line->percentage == noPercentage);
+		read.push_back(*line);
+		for (size_t i = 0; i < read.size(); i++)
+			CHECK(read.percentage(i) == noPercentage);
+
+		TimeHistogram histogram;
+		histogram.addAll(read.percentages());
+		histogram.add(noPercentage);
+		histogram.add(3);
+		histogram.takeDirty();
+		CHECK(histogram.maximum() == 1);
+		uint32_t total = 0;
+		for (int column = 0; column < TimeHistogram::columns; column++)
+			total += histogram.count(column);
+		CHECK(total == 1);
+		histogram.removeAll(read.percentages());
+		histogram.remove(noPercentage);
+		CHECK(histogram.maximum() == 1);
+	}
+
+	void testJournal(std::filesystem::path const& directory) {
+		auto const path = directory / "journal.bin";
+		std::filesystem::remove(path);
+		auto const deaths = makeDeaths(500);
+
+		DeathJournal journal;
+		CHECK(journal.open(path, 1000));
+		for (size_t i = 0; i < 300; i++) journal.append(deaths.entry(i));
+		journal.close();
+
+		// Continued by a later session on top of the same save
+		CHECK(journal.open(path, 1000));
+		for (size_t i = 300; i < deaths.size(); i++) journal.append(deaths.entry(i));
+		journal.close();
+
+		DeathStore read;
+		CHECK(readJournal(path, 1000, &read) == deaths.size());
+		checkSame(read, deaths, true);
+
+		// A journal of another save is ignored
+		DeathStore other;
+		CHECK(readJournal(path, 999, &other) == 0);
+		CHECK(other.empty());
+	}
+
+}
+
+void test::testLocal() {
+	auto const directory = tempDirectory();
+	testSave(directory);
+	testUntimed(directory);
+	testJournal(directory);
+	std::filesystem::remove_all(directory);
+}
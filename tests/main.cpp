@@ -0,0 +1,43 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "tests.hpp"
+
+using namespace dm;
+
+static size_t failures = 0;
+
+void test::fail(char const* file, int line, char const* expression) {
+	failures++;
+	std::printf("%s:%d: check failed: %s\n", file, line, expression);
+}
+
+std::vector<Vec2> test::makePositions(size_t count, uint32_t seed) {
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<float> xDist(0, 30000);
+	std::normal_distribution<float> yDist(300, 120);
+
+	std::vector<Vec2> positions;
+	positions.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		positions.push_back({ xDist(gen), yDist(gen) });
+	return positions;
+}
+
+int main(int argc, char** argv) {
+	char const* filter = argc > 1 ? argv[1] : nullptr;
+	auto run = [filter](char const* name, void (*suite)()) {
+		if (filter && std::strcmp(filter, name) != 0) return;
+		size_t const before = failures;
+		suite();
+		std::printf("%-8s %s\n", name, failures == before ? "ok" : "FAILED");
+	};
+
+	run("decode", test::testDecode);
+	run("store", test::testStore);
+	run("search", test::testSearch);
+	run("local", test::testLocal);
+	run("heatmap", test::testHeatmap);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+#include <algorithm>
+#include "tests.hpp"
+#include "core/search.hpp"
+
+using namespace dm;
+
+void test::testSearch() {
+	// Every length up to a few powers of two, with repeated keys
+	for (size_t count = 0; count <= 70; count++) {
+		std::vector<float> xs(count);
+		for (size_t i = 0; i < count; i++) xs[i] = static_cast<float>(i / 3);
+
+		for (float x = -1; x <= count / 3 + 1; x += 0.5f) {
+			CHECK(lowerBoundBranchless(xs, x) ==
+				size_t(std::lower_bound(xs.begin(), xs.end(), x) - xs.begin()));
+			CHECK(upperBoundBranchless(xs, x) ==
+				size_t(std::upper_bound(xs.begin(), xs.end(), x) - xs.begin()));
+		}
+	}
+
+	auto positions = test::makePositions(100000);
+	std::vector<float> xs;
+	for (auto const& pos : positions) xs.push_back(pos.x);
+	std::sort(xs.begin(), xs.end());
+	for (size_t i = 0; i < 5000; i++) {
+		float const x = positions[i].x + (i % 3 == 0 ? 0.f : 0.25f);
+		CHECK(lowerBoundBranchless(xs, x) ==
+			size_t(std::lower_bound(xs.begin(), xs.end(), x) - xs.begin()));
+		CHECK(upperBoundBranchless(xs, x) ==
+			size_t(std::upper_bound(xs.begin(), xs.end(), x) - xs.begin()));
+	}
+}
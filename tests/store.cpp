@@ -0,0 +1,192 @@
+#include <algorithm>
+#include "tests.hpp"
+#include "core/chunkedStore.hpp"
+#include "core/deathStore.hpp"
+
+using namespace dm;
+
+namespace {
+
+	// Small xorshift, the same sequence on every platform
+	struct Random {
+		uint32_t state;
+		uint32_t next() {
+			this->state ^= this->state << 13;
+			this->state ^= this->state >> 17;
+			this->state ^= this->state << 5;
+			return this->state;
+		}
+		// Coarse positions so that equal x occur
+		Vec2 position() {
+			return { static_cast<float>(this->next() % 50000) / 4, static_cast<float>(this->next() % 300) };
+		}
+	};
+
+	DeathStore sortedStore(size_t count, int firstPercentage, Random& random) {
+		DeathStore deaths;
+		for (size_t i = 0; i < count; i++)
+			deaths.push_back(random.position(), firstPercentage + static_cast<int>(i));
+		deaths.sortByX();
+		return deaths;
+	}
+
+	void checkSame(ChunkedDeathStore const& chunked, DeathStore const& reference) {
+		CHECK(chunked.size() == reference.size());
+		if (chunked.size() != reference.size()) return;
+
+		size_t index = 0;
+		chunked.forEachSpan(0, chunked.size(), [&](ChunkedDeathStore::Span span) {
+			for (size_t i = 0; i < span.x.size(); i++, index++) {
+				CHECK(span.x[i] == reference.x(index));
+				CHECK(span.y[i] == reference.y(index));
+				CHECK(span.percentage[i] == reference.percentage(index));
+			}
+		});
+		CHECK(index == reference.size());
+
+		for (size_t i = 0; i < reference.size(); i++) {
+			CHECK(chunked.pos(i) == reference.pos(i));
+			CHECK((chunked.ghost(i) == nullptr) == (reference.ghost(i) == nullptr));
+			if (chunked.ghost(i) && reference.ghost(i))
+				CHECK(chunked.ghost(i)->rotation == reference.ghost(i)->rotation);
+		}
+	}
+
+	void testDeathStore() {
+		Random random{ 7 };
+		auto deaths = sortedStore(3000, 0, random);
+		CHECK(deaths.isSorted());
+
+		// Merging keeps stored deaths first among equal x
+		auto other = sortedStore(2000, 3000, random);
+		size_t const tracked = 1234;
+		float const trackedX = deaths.x(tracked);
+		int const trackedPercentage = deaths.percentage(tracked);
+		size_t const moved = deaths.merge(other, tracked);
+		CHECK(deaths.size() == 5000);
+		CHECK(deaths.isSorted());
+		CHECK(deaths.x(moved) == trackedX);
+		CHECK(deaths.percentage(moved) == trackedPercentage);
+		for (size_t i = 1; i < deaths.size(); i++) {
+			if (deaths.x(i - 1) == deaths.x(i) &&
+				deaths.percentage(i - 1) >= 3000)
+				CHECK(deaths.percentage(i) >= 3000);
+		}
+
+		// Inserting goes after all deaths with the same x
+		float const x = deaths.x(2500);
+		size_t const index = deaths.insert({ x, 1 }, -1, GhostPose{ 90 });
+		CHECK(deaths.isSorted());
+		CHECK(deaths.x(index) == x);
+		CHECK(index + 1 == deaths.size() || deaths.x(index + 1) > x);
+		CHECK(deaths.ghost(index) && deaths.ghost(index)->rotation == 90);
+		CHECK(!deaths.ghost(index - 1));
+	}
+
+	void testChunkedStore() {
+		Random random{ 3 };
+		ChunkedDeathStore chunked;
+		DeathStore reference;
+		std::vector<ChunkedDeathStore::Handle> handles;
+		int percentage = 0;
+
+		// Enough inserts to split chunks several times
+		for (size_t i = 0; i < 6000; i++, percentage++) {
+			auto pos = random.position();
+			std::optional<GhostPose> ghost;
+			if (i % 5 == 0) ghost = GhostPose{ static_cast<float>(i) };
+			handles.push_back(chunked.insert(pos, percentage, ghost));
+			reference.insert(pos, percentage, ghost);
+		}
+		checkSame(chunked, reference);
+
+		for (auto handle : handles) {
+			size_t const index = chunked.indexOf(handle);
+			CHECK(index != ChunkedDeathStore::npos);
+			CHECK(chunked.refersTo(handle, index));
+			CHECK(chunked.x(index) == handle.x);
+		}
+
+		// Bounds agree with the flat columns
+		for (size_t i = 0; i < 500; i++) {
+			float const x = random.position().x;
+			auto xs = reference.xs();
+			CHECK(chunked.lowerBound(x) ==
+				size_t(std::lower_bound(xs.begin(), xs.end(), x) - xs.begin()));
+			CHECK(chunked.upperBound(x) ==
+				size_t(std::upper_bound(xs.begin(), xs.end(), x) - xs.begin()));
+		}
+
+		// Erasing within a chunk, across chunks and up to the end
+		for (auto [begin, end] : { std::pair<size_t, size_t>{ 10, 20 },
+			{ 1000, 4500 }, { 0, 1 }, { 1400, 1500 } }) {
+			chunked.erase(begin, end);
+			reference.erase(begin, end);
+			checkSame(chunked, reference);
+		}
+		chunked.erase(chunked.size() - 100, chunked.size());
+		reference.truncate(reference.size() - 100);
+		checkSame(chunked, reference);
+
+		size_t erased = 0;
+		for (auto handle : handles) {
+			size_t const index = chunked.indexOf(handle);
+			if (index == ChunkedDeathStore::npos) erased++;
+			else CHECK(chunked.refersTo(handle, index));
+		}
+		CHECK(erased == handles.size() - chunked.size());
+
+		// Merging into the middle, before everything and after everything
+		auto middle = sortedStore(5000, percentage, random);
+		percentage += 5000;
+		chunked.merge(middle);
+		reference.merge(middle);
+		checkSame(chunked, reference);
+
+		DeathStore outside;
+		outside.push_back({ -10, 0 }, percentage++);
+		outside.push_back({ -5, 0 }, percentage++);
+		outside.push_back({ 20000, 0 }, percentage++);
+		chunked.merge(outside);
+		reference.merge(outside);
+		checkSame(chunked, reference);
+
+		// Single deaths between and at the same x as stored ones
+		for (size_t index : { chunked.size() / 2, size_t(0), chunked.size() - 1 }) {
+			DeathStore single;
+			single.push_back({ chunked.x(index), 1 }, percentage++);
+			chunked.merge(single);
+			reference.merge(single);
+			checkSame(chunked, reference);
+		}
+
+		DeathStore tail;
+		tail.push_back({ 30000, 0 }, percentage++);
+		chunked.merge(tail);
+		reference.merge(tail);
+		checkSame(chunked, reference);
+
+		// Handles of deaths that survived still find them after merging
+		for (auto handle : handles) {
+			size_t const index = chunked.indexOf(handle);
+			if (index != ChunkedDeathStore::npos) {
+				CHECK(chunked.refersTo(handle, index));
+				CHECK(chunked.x(index) == handle.x);
+			}
+		}
+
+		ChunkedDeathStore empty;
+		empty.merge(middle);
+		DeathStore copy = middle;
+		checkSame(empty, copy);
+		empty.clear();
+		CHECK(empty.empty());
+		CHECK(empty.lowerBound(0) == 0);
+	}
+
+}
+
+void test::testStore() {
+	testDeathStore();
+	testChunkedStore();
+}
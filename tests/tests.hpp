@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "core/model.hpp"
+
+// Minimal test runner for the headless core, see tests/main.cpp
+
+namespace dm::test {
+
+	// Records a failed check, the runner exits non-zero if there were any
+	void fail(char const* file, int line, char const* expression);
+
+	// Deterministic synthetic data, roughly shaped like a real level
+	std::vector<Vec2> makePositions(size_t count, uint32_t seed = 1);
+
+	// Suites
+	void testDecode();
+	void testStore();
+	void testSearch();
+	void testLocal();
+	void testHeatmap();
+
+}
+
+#define CHECK(expression) \
+	do { \
+		if (!(expression)) dm::test::fail(__FILE__, __LINE__, #expression); \
+	} while (false)